@@ -0,0 +1,83 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+ZipfGenerator::ZipfGenerator(int size, double exponent) {
+    cumulative_weights_.reserve(size);
+    double sum = 0.0;
+    for (int rank = 1; rank <= size; ++rank) {
+        sum += 1.0 / pow(rank, exponent);
+        cumulative_weights_.push_back(sum);
+    }
+}
+
+int ZipfGenerator::operator()(mt19937& generator) const {
+    uniform_real_distribution<double> distribution(0.0, cumulative_weights_.back());
+    const auto it = lower_bound(cumulative_weights_.begin(), cumulative_weights_.end(), distribution(generator));
+    return static_cast<int>(min(it - cumulative_weights_.begin(), static_cast<ptrdiff_t>(cumulative_weights_.size()) - 1));
+}
+
+string MakeWord(int rank) {
+    string word;
+    do {
+        word += static_cast<char>('a' + rank % 26);
+        rank /= 26;
+    } while (rank > 0);
+    return word;
+}
+
+vector<GeneratedDocument> GenerateCorpus(const CorpusOptions& options) {
+    mt19937 generator(options.seed);
+    const ZipfGenerator zipf(options.vocabulary_size, options.zipf_exponent);
+    uniform_int_distribution<int> document_length(options.min_document_length, options.max_document_length);
+    bernoulli_distribution is_duplicate(options.duplicate_ratio);
+    // Most documents are actual, as in a live index
+    discrete_distribution<int> status({ 85, 5, 5, 5 });
+    uniform_int_distribution<int> rating_count(1, 3);
+    uniform_int_distribution<int> rating(-10, 10);
+
+    vector<GeneratedDocument> documents;
+    documents.reserve(options.document_count);
+    for (int id = 0; id < options.document_count; ++id) {
+        GeneratedDocument document{ id, {}, static_cast<DocumentStatus>(status(generator)), {} };
+        if (!documents.empty() && is_duplicate(generator)) {
+            uniform_int_distribution<size_t> original(0, documents.size() - 1);
+            document.text = documents[original(generator)].text;
+        }
+        else {
+            const int word_count = document_length(generator);
+            for (int i = 0; i < word_count; ++i) {
+                document.text += MakeWord(zipf(generator));
+                document.text += ' ';
+            }
+        }
+        for (int i = rating_count(generator); i > 0; --i) {
+            document.ratings.push_back(rating(generator));
+        }
+        documents.push_back(move(document));
+    }
+    return documents;
+}
+
+vector<string> GenerateQueries(const CorpusOptions& corpus_options, const QueryOptions& options) {
+    mt19937 generator(options.seed);
+    const ZipfGenerator zipf(corpus_options.vocabulary_size, corpus_options.zipf_exponent);
+    uniform_int_distribution<int> query_length(options.min_query_length, options.max_query_length);
+    bernoulli_distribution is_minus_word(options.minus_word_ratio);
+
+    vector<string> queries(options.query_count);
+    for (string& query : queries) {
+        const int word_count = query_length(generator);
+        for (int i = 0; i < word_count; ++i) {
+            if (is_minus_word(generator)) {
+                query += '-';
+            }
+            query += MakeWord(zipf(generator));
+            query += ' ';
+        }
+    }
+    return queries;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../document.h"
+
+struct CorpusOptions {
+    int document_count = 20000;
+    int vocabulary_size = 20000;
+    // Weight of the word of rank r is 1 / r^zipf_exponent
+    double zipf_exponent = 1.0;
+    int min_document_length = 10;
+    int max_document_length = 50;
+    // Share of documents copying the text of an earlier one, removed by RemoveDuplicates
+    double duplicate_ratio = 0.0;
+    uint32_t seed = 42;
+};
+
+struct QueryOptions {
+    int query_count = 2000;
+    int min_query_length = 1;
+    int max_query_length = 4;
+    // Share of query words written as minus words
+    double minus_word_ratio = 0.1;
+    uint32_t seed = 4242;
+};
+
+struct GeneratedDocument {
+    int id;
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Draws word ranks counted from zero, so that frequencies follow Zipf's law as in
+// natural text and query logs
+class ZipfGenerator {
+public:
+    ZipfGenerator(int size, double exponent);
+
+    int operator()(std::mt19937& generator) const;
+
+private:
+    std::vector<double> cumulative_weights_;
+};
+
+// Distinct word of the vocabulary for every rank
+std::string MakeWord(int rank);
+
+// The same options always give the same corpus and queries
+std::vector<GeneratedDocument> GenerateCorpus(const CorpusOptions& options);
+
+// Queries draw their words from the vocabulary of the corpus
+std::vector<std::string> GenerateQueries(const CorpusOptions& corpus_options, const QueryOptions& options);
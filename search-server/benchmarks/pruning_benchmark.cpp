@@ -0,0 +1,64 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+namespace {
+
+double MeasureSeconds(const SearchServer& search_server, const vector<string>& queries, vector<vector<Document>>& results) {
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < queries.size(); ++i) {
+        results[i] = search_server.FindTopDocuments(queries[i]);
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+// Compares exhaustive and pruned retrieval on a Zipf corpus with queries that mix
+// frequent and rare words, and checks that both return the same documents
+int main() {
+    CorpusOptions corpus_options;
+    corpus_options.document_count = 200000;
+    corpus_options.vocabulary_size = 50000;
+    corpus_options.max_document_length = 49;
+    QueryOptions query_options;
+    query_options.min_query_length = 2;
+    query_options.max_query_length = 5;
+    query_options.minus_word_ratio = 0.0;
+
+    SearchServer search_server("and in on the"s);
+    for (const GeneratedDocument& document : GenerateCorpus(corpus_options)) {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    const vector<string> queries = GenerateQueries(corpus_options, query_options);
+
+    vector<vector<Document>> exhaustive_results(queries.size());
+    vector<vector<Document>> pruned_results(queries.size());
+    search_server.SetRetrievalMode(RetrievalMode::EXHAUSTIVE);
+    const double exhaustive_seconds = MeasureSeconds(search_server, queries, exhaustive_results);
+    search_server.SetRetrievalMode(RetrievalMode::PRUNED);
+    const double pruned_seconds = MeasureSeconds(search_server, queries, pruned_results);
+
+    size_t mismatch_count = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto& expected = exhaustive_results[i];
+        const auto& actual = pruned_results[i];
+        const bool is_equal = expected.size() == actual.size()
+            && equal(expected.begin(), expected.end(), actual.begin(), [](const Document& lhs, const Document& rhs) {
+                return lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating;
+            });
+        mismatch_count += is_equal ? 0 : 1;
+    }
+
+    cout << "exhaustive: "s << exhaustive_seconds << " s"s << endl;
+    cout << "pruned: "s << pruned_seconds << " s"s << endl;
+    cout << "speedup: "s << exhaustive_seconds / pruned_seconds << endl;
+    cout << "mismatched queries: "s << mismatch_count << endl;
+    return mismatch_count == 0 ? 0 : 1;
+}
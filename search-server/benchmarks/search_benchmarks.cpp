@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../concurrent_search_server.h"
+#include "../paginator.h"
+#include "../read_input_functions.h"
+#include "../remove_duplicates.h"
+#include "../request_queue.h"
+#include "../search_server.h"
+#include "corpus_generator.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on the"s;
+const size_t PAGINATED_PAGE = 3;
+
+struct BenchmarkOptions {
+    CorpusOptions corpus;
+    QueryOptions queries;
+    int repetitions = 5;
+    // Only benchmarks whose names contain the filter are run
+    string filter;
+};
+
+// Input shared by the benchmarks, the server is indexed from documents
+struct Fixture {
+    const vector<GeneratedDocument>& documents;
+    const vector<string>& queries;
+    const SearchServer& search_server;
+};
+
+struct Measurement {
+    double seconds;
+    // Folds the results, so equal checksums before and after a change mean equal results
+    uint64_t checksum;
+};
+
+struct Benchmark {
+    string name;
+    // Number of operations a repetition performs
+    function<size_t(const Fixture&)> operation_count;
+    // Prepares its own input, only the part inside Measure is timed
+    function<Measurement(const Fixture&)> run;
+};
+
+template <typename Action>
+Measurement Measure(Action action) {
+    const auto start = chrono::steady_clock::now();
+    const uint64_t checksum = action();
+    return { chrono::duration<double>(chrono::steady_clock::now() - start).count(), checksum };
+}
+
+uint64_t MixChecksum(uint64_t checksum, uint64_t value) {
+    return (checksum ^ value) * 0x100000001B3;
+}
+
+uint64_t MixChecksum(uint64_t checksum, const vector<Document>& documents) {
+    checksum = MixChecksum(checksum, documents.size());
+    for (const Document& document : documents) {
+        checksum = MixChecksum(checksum, static_cast<uint64_t>(document.id));
+    }
+    return checksum;
+}
+
+template <typename ExecutionPolicy>
+Measurement FindTopDocuments(ExecutionPolicy&& policy, const SearchServer& search_server, const vector<string>& queries) {
+    return Measure([&]() {
+        uint64_t checksum = 0;
+        for (const string& query : queries) {
+            checksum = MixChecksum(checksum, search_server.FindTopDocuments(policy, query));
+        }
+        return checksum;
+    });
+}
+
+vector<Benchmark> MakeBenchmarks() {
+    const auto document_count = [](const Fixture& fixture) {
+        return fixture.documents.size();
+    };
+    const auto query_count = [](const Fixture& fixture) {
+        return fixture.queries.size();
+    };
+    // Every tenth document, so that the removals spread over the whole index
+    const auto removed_count = [](const Fixture& fixture) {
+        return (fixture.documents.size() + 9) / 10;
+    };
+
+    vector<Benchmark> benchmarks;
+    benchmarks.push_back({ "add_document"s, document_count, [](const Fixture& fixture) {
+        SearchServer search_server(STOP_WORDS);
+        return Measure([&]() {
+            for (const GeneratedDocument& document : fixture.documents) {
+                search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+    } });
+    benchmarks.push_back({ "add_documents_bulk"s, document_count, [](const Fixture& fixture) {
+        SearchServer search_server(STOP_WORDS);
+        vector<NewDocument> documents;
+        documents.reserve(fixture.documents.size());
+        for (const GeneratedDocument& document : fixture.documents) {
+            documents.push_back({ document.id, document.text, document.status, document.ratings });
+        }
+        return Measure([&]() {
+            search_server.AddDocuments(documents);
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+    } });
+    benchmarks.push_back({ "concurrent_add_document"s, document_count, [](const Fixture& fixture) {
+        ConcurrentSearchServer search_server(STOP_WORDS);
+        return Measure([&]() {
+            for (const GeneratedDocument& document : fixture.documents) {
+                search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+            }
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+    } });
+    benchmarks.push_back({ "load_corpus"s, document_count, [](const Fixture& fixture) {
+        const string path = (filesystem::temp_directory_path() / "search_benchmarks_corpus.tsv"s).string();
+        {
+            ofstream output(path, ios::binary | ios::trunc);
+            for (const GeneratedDocument& document : fixture.documents) {
+                output << document.id << '\t' << static_cast<int>(document.status) << '\t';
+                for (size_t i = 0; i < document.ratings.size(); ++i) {
+                    output << (i == 0 ? ""s : " "s) << document.ratings[i];
+                }
+                output << '\t' << document.text << '\n';
+            }
+        }
+        SearchServer search_server(STOP_WORDS);
+        const Measurement measurement = Measure([&]() {
+            LoadCorpus(search_server, path);
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+        filesystem::remove(path);
+        return measurement;
+    } });
+    // Every posting is scored, the baseline of find_top_documents_pruned
+    benchmarks.push_back({ "find_top_documents_seq"s, query_count, [](const Fixture& fixture) {
+        SearchServer search_server(fixture.search_server);
+        search_server.SetRetrievalMode(RetrievalMode::EXHAUSTIVE);
+        return FindTopDocuments(execution::seq, search_server, fixture.queries);
+    } });
+    benchmarks.push_back({ "find_top_documents_par"s, query_count, [](const Fixture& fixture) {
+        return FindTopDocuments(execution::par, fixture.search_server, fixture.queries);
+    } });
+    benchmarks.push_back({ "find_top_documents_pruned"s, query_count, [](const Fixture& fixture) {
+        SearchServer search_server(fixture.search_server);
+        search_server.SetRetrievalMode(RetrievalMode::PRUNED);
+        return FindTopDocuments(execution::seq, search_server, fixture.queries);
+    } });
+    // The fourth page of results: sorted out of the full result set, then streamed from a top-k search
+    benchmarks.push_back({ "paginate_full_results"s, query_count, [](const Fixture& fixture) {
+        return Measure([&]() {
+            uint64_t checksum = 0;
+            for (const string& query : fixture.queries) {
+                const vector<Document> documents = fixture.search_server.FindTopDocuments(execution::seq, query,
+                    DocumentStatus::ACTUAL, numeric_limits<size_t>::max());
+                const auto page = Paginate(documents, MAX_RESULT_DOCUMENT_COUNT).GetPage(PAGINATED_PAGE);
+                checksum = MixChecksum(checksum, vector<Document>(page.begin(), page.end()));
+            }
+            return checksum;
+        });
+    } });
+    benchmarks.push_back({ "paginate_top_results"s, query_count, [](const Fixture& fixture) {
+        return Measure([&]() {
+            uint64_t checksum = 0;
+            for (const string& query : fixture.queries) {
+                auto pages = PaginateTop([&](size_t top_count) {
+                    return fixture.search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, top_count);
+                }, MAX_RESULT_DOCUMENT_COUNT);
+                checksum = MixChecksum(checksum, pages.GetPage(PAGINATED_PAGE));
+            }
+            return checksum;
+        });
+    } });
+    benchmarks.push_back({ "match_document_seq"s, query_count, [](const Fixture& fixture) {
+        const SearchServer& search_server = fixture.search_server;
+        return Measure([&]() {
+            uint64_t checksum = 0;
+            for (size_t i = 0; i < fixture.queries.size(); ++i) {
+                const int document_id = fixture.documents[i % fixture.documents.size()].id;
+                const auto [words, status] = search_server.MatchDocument(fixture.queries[i], document_id);
+                checksum = MixChecksum(checksum, words.size());
+            }
+            return checksum;
+        });
+    } });
+    benchmarks.push_back({ "match_document_par"s, query_count, [](const Fixture& fixture) {
+        const SearchServer& search_server = fixture.search_server;
+        return Measure([&]() {
+            uint64_t checksum = 0;
+            for (size_t i = 0; i < fixture.queries.size(); ++i) {
+                const int document_id = fixture.documents[i % fixture.documents.size()].id;
+                const auto [words, status] = search_server.MatchDocument(execution::par, fixture.queries[i], document_id);
+                checksum = MixChecksum(checksum, words.size());
+            }
+            return checksum;
+        });
+    } });
+    benchmarks.push_back({ "remove_document_seq"s, removed_count, [](const Fixture& fixture) {
+        SearchServer search_server(fixture.search_server);
+        return Measure([&]() {
+            for (size_t i = 0; i < fixture.documents.size(); i += 10) {
+                search_server.RemoveDocument(execution::seq, fixture.documents[i].id);
+            }
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+    } });
+    benchmarks.push_back({ "remove_document_par"s, removed_count, [](const Fixture& fixture) {
+        SearchServer search_server(fixture.search_server);
+        return Measure([&]() {
+            for (size_t i = 0; i < fixture.documents.size(); i += 10) {
+                search_server.RemoveDocument(execution::par, fixture.documents[i].id);
+            }
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+    } });
+    benchmarks.push_back({ "remove_duplicates"s, document_count, [](const Fixture& fixture) {
+        SearchServer search_server(fixture.search_server);
+        // Every removal is reported to cout, which would break the output format
+        streambuf* output = cout.rdbuf(nullptr);
+        const Measurement measurement = Measure([&]() {
+            RemoveDuplicates(search_server);
+            return static_cast<uint64_t>(search_server.GetDocumentCount());
+        });
+        cout.rdbuf(output);
+        return measurement;
+    } });
+    benchmarks.push_back({ "request_queue"s, query_count, [](const Fixture& fixture) {
+        RequestQueue request_queue(fixture.search_server);
+        return Measure([&]() {
+            uint64_t checksum = 0;
+            for (const string& query : fixture.queries) {
+                checksum = MixChecksum(checksum, request_queue.AddFindRequest(query));
+            }
+            return MixChecksum(checksum, request_queue.GetNoResultRequests());
+        });
+    } });
+    return benchmarks;
+}
+
+// Options are written as --name=value
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    // RemoveDuplicates has something to remove
+    options.corpus.duplicate_ratio = 0.05;
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t separator = argument.find('=');
+        if (argument.substr(0, 2) != "--"sv || separator == argument.npos) {
+            throw invalid_argument("неверный аргумент "s + string(argument));
+        }
+        const string_view name = argument.substr(2, separator - 2);
+        const string value(argument.substr(separator + 1));
+        if (name == "documents"sv) {
+            options.corpus.document_count = stoi(value);
+        }
+        else if (name == "vocabulary"sv) {
+            options.corpus.vocabulary_size = stoi(value);
+        }
+        else if (name == "zipf-exponent"sv) {
+            options.corpus.zipf_exponent = stod(value);
+        }
+        else if (name == "min-document-length"sv) {
+            options.corpus.min_document_length = stoi(value);
+        }
+        else if (name == "max-document-length"sv) {
+            options.corpus.max_document_length = stoi(value);
+        }
+        else if (name == "duplicate-ratio"sv) {
+            options.corpus.duplicate_ratio = stod(value);
+        }
+        else if (name == "seed"sv) {
+            options.corpus.seed = static_cast<uint32_t>(stoul(value));
+            options.queries.seed = options.corpus.seed + 1;
+        }
+        else if (name == "queries"sv) {
+            options.queries.query_count = stoi(value);
+        }
+        else if (name == "min-query-length"sv) {
+            options.queries.min_query_length = stoi(value);
+        }
+        else if (name == "max-query-length"sv) {
+            options.queries.max_query_length = stoi(value);
+        }
+        else if (name == "minus-word-ratio"sv) {
+            options.queries.minus_word_ratio = stod(value);
+        }
+        else if (name == "repetitions"sv) {
+            options.repetitions = stoi(value);
+        }
+        else if (name == "filter"sv) {
+            options.filter = value;
+        }
+        else {
+            throw invalid_argument("неизвестный параметр "s + string(name));
+        }
+    }
+    if (options.corpus.document_count <= 0 || options.queries.query_count <= 0 || options.repetitions <= 0) {
+        throw invalid_argument("количество документов, запросов и повторов должно быть положительным"s);
+    }
+    return options;
+}
+
+void PrintConfig(const BenchmarkOptions& options) {
+    cout << "{\"type\":\"config\""s
+        << ",\"documents\":"s << options.corpus.document_count
+        << ",\"vocabulary\":"s << options.corpus.vocabulary_size
+        << ",\"zipf_exponent\":"s << options.corpus.zipf_exponent
+        << ",\"min_document_length\":"s << options.corpus.min_document_length
+        << ",\"max_document_length\":"s << options.corpus.max_document_length
+        << ",\"duplicate_ratio\":"s << options.corpus.duplicate_ratio
+        << ",\"seed\":"s << options.corpus.seed
+        << ",\"queries\":"s << options.queries.query_count
+        << ",\"min_query_length\":"s << options.queries.min_query_length
+        << ",\"max_query_length\":"s << options.queries.max_query_length
+        << ",\"minus_word_ratio\":"s << options.queries.minus_word_ratio
+        << ",\"repetitions\":"s << options.repetitions << "}"s << endl;
+}
+
+void PrintResult(const string& name, size_t operation_count, vector<Measurement> measurements) {
+    sort(measurements.begin(), measurements.end(), [](const Measurement& lhs, const Measurement& rhs) {
+        return lhs.seconds < rhs.seconds;
+    });
+    // Repetitions run on the same input, so a differing checksum means nondeterministic results
+    const bool is_stable = all_of(measurements.begin(), measurements.end(), [&](const Measurement& measurement) {
+        return measurement.checksum == measurements.front().checksum;
+    });
+    const double nanoseconds_per_second = 1e9;
+    const double operations = static_cast<double>(max<size_t>(operation_count, 1));
+    cout << "{\"type\":\"result\""s
+        << ",\"benchmark\":\""s << name << '"'
+        << ",\"operations\":"s << operation_count
+        << ",\"min_ns_per_op\":"s << measurements.front().seconds * nanoseconds_per_second / operations
+        << ",\"median_ns_per_op\":"s << measurements[measurements.size() / 2].seconds * nanoseconds_per_second / operations
+        << ",\"max_ns_per_op\":"s << measurements.back().seconds * nanoseconds_per_second / operations
+        << ",\"checksum\":"s << measurements.front().checksum
+        << ",\"stable\":"s << (is_stable ? "true"s : "false"s) << "}"s << endl;
+}
+
+}  // namespace
+
+// Prints one JSON object per line: the configuration first, then a result per benchmark.
+// Runs with equal options see equal corpora, so their results can be compared line by line
+int main(int argc, char* argv[]) {
+    try {
+        const BenchmarkOptions options = ParseOptions(argc, argv);
+        PrintConfig(options);
+
+        const vector<GeneratedDocument> documents = GenerateCorpus(options.corpus);
+        const vector<string> queries = GenerateQueries(options.corpus, options.queries);
+        SearchServer search_server(STOP_WORDS);
+        for (const GeneratedDocument& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        const Fixture fixture{ documents, queries, search_server };
+
+        for (const Benchmark& benchmark : MakeBenchmarks()) {
+            if (benchmark.name.find(options.filter) == string::npos) {
+                continue;
+            }
+            vector<Measurement> measurements;
+            for (int i = 0; i < options.repetitions; ++i) {
+                measurements.push_back(benchmark.run(fixture));
+            }
+            PrintResult(benchmark.name, benchmark.operation_count(fixture), measurements);
+        }
+    }
+    catch (const exception& e) {
+        cerr << "Ошибка: "s << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "concurrent_search_server.h"
+
+#include <cmath>
+#include <thread>
+
+using namespace std;
+
+ConcurrentSearchServer::ConcurrentSearchServer(string_view stop_words_text, size_t shard_count) {
+    if (shard_count == 0) {
+        throw invalid_argument("количество шардов должно быть положительным"s);
+    }
+    const SearchServer empty_shard(stop_words_text);
+    for (Shards& shards : copies_) {
+        shards.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards.push_back(empty_shard);
+        }
+    }
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    if (document_id < 0) {
+        throw invalid_argument("документ с отрицательным id"s);
+    }
+    ModifyShard(document_id, [&](SearchServer& shard) {
+        shard.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    if (document_id < 0) {
+        return;
+    }
+    ModifyShard(document_id, [document_id](SearchServer& shard) {
+        shard.RemoveDocument(document_id);
+    });
+}
+
+vector<Document> ConcurrentSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentStatusPredicate{ status });
+}
+
+vector<Document> ConcurrentSearchServer::FindTopDocuments(string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+tuple<vector<string>, DocumentStatus> ConcurrentSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    if (document_id < 0) {
+        throw out_of_range("документ с отрицательным id"s);
+    }
+    const ReadGuard guard(*this);
+    const auto [words, status] = guard.GetShards()[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+    return { vector<string>(words.begin(), words.end()), status };
+}
+
+size_t ConcurrentSearchServer::GetDocumentCount() const {
+    const ReadGuard guard(*this);
+    size_t document_count = 0;
+    for (const SearchServer& shard : guard.GetShards()) {
+        document_count += shard.GetDocumentCount();
+    }
+    return document_count;
+}
+
+size_t ConcurrentSearchServer::GetShardIndex(int document_id) const {
+    return static_cast<size_t>(document_id) % copies_[0].size();
+}
+
+void ConcurrentSearchServer::WaitForReaders(size_t copy_index) const {
+    while (reader_counts_[copy_index].load(memory_order_seq_cst) != 0) {
+        this_thread::yield();
+    }
+}
+
+pmr::vector<double> ConcurrentSearchServer::ComputeInverseDocumentFreqs(const Shards& shards, const SearchServer::Query& query,
+    pmr::memory_resource* resource) {
+    size_t document_count = 0;
+    for (const SearchServer& shard : shards) {
+        document_count += shard.GetDocumentCount();
+    }
+    pmr::vector<double> inverse_document_freqs(query.plus_words.size(), resource);
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        size_t word_document_count = 0;
+        for (const SearchServer& shard : shards) {
+            if (const auto* postings = shard.FindPostings(query.plus_words[i])) {
+                word_document_count += postings->size();
+            }
+        }
+        if (word_document_count > 0) {
+            inverse_document_freqs[i] = std::log(document_count * 1.0 / word_document_count);
+        }
+    }
+    return inverse_document_freqs;
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(const ConcurrentSearchServer& search_server)
+    : search_server_(search_server)
+{
+    // A writer may have switched copies before the registration became visible and no
+    // longer wait for it, so the query registers again with the new active copy
+    while (true) {
+        copy_index_ = search_server_.active_copy_index_.load(memory_order_seq_cst);
+        search_server_.reader_counts_[copy_index_].fetch_add(1, memory_order_seq_cst);
+        if (search_server_.active_copy_index_.load(memory_order_seq_cst) == copy_index_) {
+            break;
+        }
+        search_server_.reader_counts_[copy_index_].fetch_sub(1, memory_order_seq_cst);
+    }
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard() {
+    search_server_.reader_counts_[copy_index_].fetch_sub(1, memory_order_seq_cst);
+}
+
+const ConcurrentSearchServer::Shards& ConcurrentSearchServer::ReadGuard::GetShards() const {
+    return search_server_.copies_[copy_index_];
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "search_server.h"
+
+// Search server which accepts AddDocument and RemoveDocument while it is queried.
+// Documents are spread over shards by id. The server keeps two copies of all shards:
+// queries read the active copy, so they see the index as of one moment and never wait
+// for a writer. A writer changes the other copy, makes it active, waits until the queries
+// which still read the previous copy finish and repeats the change there. Every change
+// is thus applied twice, no shard is copied, at the price of twice the memory
+class ConcurrentSearchServer {
+public:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    explicit ConcurrentSearchServer(std::string_view stop_words_text, size_t shard_count = DEFAULT_SHARD_COUNT);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    // document_predicate is called from several threads and must be thread-safe
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // Words are copied, the copy of the index they were found in changes once the call returns
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    size_t GetDocumentCount() const;
+
+private:
+    using Shards = std::vector<SearchServer>;
+
+    // Keeps the copy a query reads from being changed until the query finishes
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConcurrentSearchServer& search_server);
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard();
+
+        const Shards& GetShards() const;
+
+    private:
+        const ConcurrentSearchServer& search_server_;
+        size_t copy_index_;
+    };
+
+    Shards copies_[2];
+    std::atomic<size_t> active_copy_index_{ 0 };
+    // Queries in progress by the copy they read
+    mutable std::atomic<int64_t> reader_counts_[2] = { 0, 0 };
+    // Serializes writers, readers never take it
+    std::mutex write_mutex_;
+
+    size_t GetShardIndex(int document_id) const;
+
+    void WaitForReaders(size_t copy_index) const;
+
+    // Inverse document frequencies of the plus words over all shards of one copy
+    static std::pmr::vector<double> ComputeInverseDocumentFreqs(const Shards& shards, const SearchServer::Query& query,
+        std::pmr::memory_resource* resource);
+
+    template <typename Modifier>
+    void ModifyShard(int document_id, Modifier modifier);
+};
+
+    template <typename DocumentPredicate>
+    std::vector<Document> ConcurrentSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count) const {
+        const ReadGuard guard(*this);
+        const Shards& shards = guard.GetShards();
+        // All shards share the stop words, so any of them parses the query
+        QueryArena arena;
+        const SearchServer::Query query = shards.front().ParseQuery(raw_query, arena.GetResource());
+        const std::pmr::vector<double> inverse_document_freqs = ComputeInverseDocumentFreqs(shards, query, arena.GetResource());
+
+        std::vector<std::vector<Document>> shard_documents(shards.size());
+        std::transform(std::execution::par, shards.begin(), shards.end(), shard_documents.begin(),
+            [&](const SearchServer& shard) {
+                return shard.FindAllDocuments(query, inverse_document_freqs, document_predicate);
+            });
+
+        std::vector<Document> matched_documents;
+        for (std::vector<Document>& documents : shard_documents) {
+            matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
+        }
+        SearchServer::SelectTopDocuments(matched_documents, top_count);
+        return matched_documents;
+    }
+
+    template <typename Modifier>
+    void ConcurrentSearchServer::ModifyShard(int document_id, Modifier modifier) {
+        std::lock_guard guard(write_mutex_);
+        const size_t active_copy_index = active_copy_index_.load(std::memory_order_relaxed);
+        const size_t shard_index = GetShardIndex(document_id);
+        // SearchServer checks its arguments before changing anything, so a rejected change
+        // throws here and leaves both copies equal
+        modifier(copies_[1 - active_copy_index][shard_index]);
+        active_copy_index_.store(1 - active_copy_index, std::memory_order_seq_cst);
+        WaitForReaders(active_copy_index);
+        modifier(copies_[active_copy_index][shard_index]);
+    }
@@ -0,0 +1,339 @@
+#include "index_snapshot.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+const size_t SECTION_ALIGNMENT = 8;
+
+template <typename Record>
+void AppendRecord(vector<char>& bytes, const Record& record) {
+    const char* data = reinterpret_cast<const char*>(&record);
+    bytes.insert(bytes.end(), data, data + sizeof(Record));
+}
+
+IndexSnapshotString AppendString(vector<char>& strings, string_view str) {
+    const IndexSnapshotString result{ strings.size(), str.size() };
+    strings.insert(strings.end(), str.begin(), str.end());
+    return result;
+}
+
+// Appends section bytes to the file image and returns their offset
+uint64_t AppendSection(vector<char>& image, const vector<char>& section) {
+    image.resize((image.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT);
+    const uint64_t offset = image.size();
+    image.insert(image.end(), section.begin(), section.end());
+    return offset;
+}
+
+[[noreturn]] void ThrowCorrupted() {
+    throw invalid_argument("повреждённый снимок индекса"s);
+}
+
+// Records [first, first + count) must lie within [0, limit)
+void CheckRange(uint64_t first, uint64_t count, uint64_t limit) {
+    if (first > limit || count > limit - first) {
+        ThrowCorrupted();
+    }
+}
+
+void CheckString(const IndexSnapshotString& string, uint64_t strings_size) {
+    CheckRange(string.offset, string.length, strings_size);
+}
+
+// Decodes the block the way PostingsList::DecodeBlock does, but never past its bytes.
+// Ordinals have to grow from the first to the last one and address existing documents
+void CheckBlock(const uint8_t* data, const IndexSnapshotBlock& block, uint64_t document_count) {
+    const uint8_t* data_end = data + block.bytes_length;
+    const auto read_varint = [&data, data_end]() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (data == data_end) {
+                ThrowCorrupted();
+            }
+            const uint8_t byte = *data++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        ThrowCorrupted();
+    };
+    if (block.size == 0 || block.last_ordinal >= document_count) {
+        ThrowCorrupted();
+    }
+    uint64_t document_ordinal = block.first_ordinal;
+    for (uint32_t i = 0; i < block.size; ++i) {
+        const uint64_t delta = read_varint();
+        if (delta > block.last_ordinal - min(document_ordinal, block.last_ordinal)) {
+            ThrowCorrupted();
+        }
+        document_ordinal += delta;
+        read_varint();
+    }
+    if (document_ordinal != block.last_ordinal) {
+        ThrowCorrupted();
+    }
+}
+
+}  // namespace
+
+void SaveIndexSnapshot(const SearchServer& search_server, const string& path) {
+    vector<char> stop_words, documents, terms, blocks, forward_entries, strings, block_bytes;
+
+    for (const string& word : search_server.stop_words_) {
+        AppendRecord(stop_words, AppendString(strings, word));
+    }
+
+    // Documents are renumbered in id order, which leaves out the ordinals of removed ones
+    vector<size_t> snapshot_ordinals(search_server.documents_.size());
+    size_t document_count = 0;
+    for (const auto [document_id, document_ordinal] : search_server.document_ordinals_) {
+        snapshot_ordinals[document_ordinal] = document_count++;
+    }
+
+    // Terms are numbered in word order, so forward entries stay sorted by word
+    vector<uint64_t> term_indexes(search_server.postings_.size());
+    uint64_t term_count = 0;
+    uint64_t block_count = 0;
+    for (const auto& [word, term_id] : search_server.term_ids_) {
+        vector<pair<size_t, uint32_t>> postings;
+        search_server.postings_[term_id].ForEach([&](size_t document_ordinal, uint32_t occurrences) {
+            postings.push_back({ snapshot_ordinals[document_ordinal], occurrences });
+        });
+        sort(postings.begin(), postings.end());
+        PostingsList snapshot_postings;
+        for (const auto& [document_ordinal, occurrences] : postings) {
+            snapshot_postings.Append(document_ordinal, occurrences);
+        }
+
+        term_indexes[term_id] = term_count++;
+        AppendRecord(terms, IndexSnapshotTerm{ AppendString(strings, word), block_count,
+            snapshot_postings.GetBlocks().size(), snapshot_postings.size() });
+        for (const PostingsList::Block& block : snapshot_postings.GetBlocks()) {
+            AppendRecord(blocks, IndexSnapshotBlock{ block.first_ordinal, block.last_ordinal, block_bytes.size(),
+                block.size, block.byte_count });
+            const uint8_t* bytes = snapshot_postings.GetBlockBytes(block);
+            block_bytes.insert(block_bytes.end(), bytes, bytes + block.byte_count);
+            ++block_count;
+        }
+    }
+
+    uint64_t forward_entry_count = 0;
+    for (const auto [document_id, document_ordinal] : search_server.document_ordinals_) {
+        const auto& document_data = search_server.documents_[document_ordinal];
+        const uint32_t entry_count = search_server.forward_spans_[document_ordinal].size;
+        const SearchServer::ForwardEntry* entries = search_server.GetForwardEntries(document_ordinal);
+        AppendRecord(documents, IndexSnapshotDocument{ document_id, search_server.document_ratings_[document_ordinal],
+            static_cast<int32_t>(search_server.document_statuses_[document_ordinal]), entry_count,
+            forward_entry_count, document_data.inv_word_count });
+        for (uint32_t i = 0; i < entry_count; ++i) {
+            AppendRecord(forward_entries, IndexSnapshotForwardEntry{ term_indexes[entries[i].term_id] });
+            ++forward_entry_count;
+        }
+    }
+
+    IndexSnapshotHeader header{};
+    memcpy(header.magic, INDEX_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = INDEX_SNAPSHOT_VERSION;
+    vector<char> image(sizeof(header));
+    header.stop_words = { AppendSection(image, stop_words), search_server.stop_words_.size() };
+    header.documents = { AppendSection(image, documents), document_count };
+    header.terms = { AppendSection(image, terms), term_count };
+    header.blocks = { AppendSection(image, blocks), block_count };
+    header.forward_entries = { AppendSection(image, forward_entries), forward_entry_count };
+    header.strings = { AppendSection(image, strings), strings.size() };
+    header.block_bytes = { AppendSection(image, block_bytes), block_bytes.size() };
+    memcpy(image.data(), &header, sizeof(header));
+
+    // Servers may have the old file mapped, truncating it would pull the pages from under them.
+    // The image goes to a new file which then replaces the old one, whose inode lives on
+    static atomic<uint64_t> temporary_file_count{ 0 };
+    const string temporary_path = path + ".tmp"s + to_string(getpid()) + "-"s + to_string(temporary_file_count++);
+    ofstream output(temporary_path, ios::binary | ios::trunc);
+    output.write(image.data(), image.size());
+    output.close();
+    if (!output || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        remove(temporary_path.c_str());
+        throw runtime_error("не удалось записать снимок индекса "s + path);
+    }
+}
+
+MappedSearchServer::MappedSearchServer(const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("не удалось открыть снимок индекса "s + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(IndexSnapshotHeader)) {
+        close(fd);
+        throw invalid_argument("неверный формат снимка индекса "s + path);
+    }
+    size_ = file_stat.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw runtime_error("не удалось отобразить снимок индекса "s + path);
+    }
+    data_ = static_cast<const char*>(data);
+
+    try {
+        header_ = reinterpret_cast<const IndexSnapshotHeader*>(data_);
+        if (memcmp(header_->magic, INDEX_SNAPSHOT_MAGIC, sizeof(header_->magic)) != 0) {
+            throw invalid_argument("неверный формат снимка индекса "s + path);
+        }
+        if (header_->version != INDEX_SNAPSHOT_VERSION) {
+            throw invalid_argument("неподдерживаемая версия снимка индекса "s + to_string(header_->version));
+        }
+        const auto* stop_words = GetSection<IndexSnapshotString>(header_->stop_words);
+        documents_ = GetSection<IndexSnapshotDocument>(header_->documents);
+        terms_ = GetSection<IndexSnapshotTerm>(header_->terms);
+        blocks_ = GetSection<IndexSnapshotBlock>(header_->blocks);
+        forward_entries_ = GetSection<IndexSnapshotForwardEntry>(header_->forward_entries);
+        strings_ = GetSection<char>(header_->strings, 1);
+        block_bytes_ = GetSection<uint8_t>(header_->block_bytes, 1);
+        Validate();
+
+        for (uint64_t i = 0; i < header_->stop_words.count; ++i) {
+            CheckString(stop_words[i], header_->strings.count);
+        }
+        vector<string_view> stop_word_views;
+        for (uint64_t i = 0; i < header_->stop_words.count; ++i) {
+            stop_word_views.push_back(GetString(stop_words[i]));
+        }
+        query_parser_ = make_unique<SearchServer>(stop_word_views);
+    }
+    catch (...) {
+        munmap(const_cast<char*>(data_), size_);
+        throw;
+    }
+}
+
+MappedSearchServer::~MappedSearchServer() {
+    munmap(const_cast<char*>(data_), size_);
+}
+
+vector<Document> MappedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentStatusPredicate{ status });
+}
+
+vector<Document> MappedSearchServer::FindTopDocuments(string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+tuple<vector<string_view>, DocumentStatus> MappedSearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    QueryArena arena;
+    const SearchServer::Query query = query_parser_->ParseQuery(raw_query, arena.GetResource());
+    const IndexSnapshotDocument& document = GetDocument(document_id);
+    const DocumentStatus status = static_cast<DocumentStatus>(document.status);
+    const IndexSnapshotForwardEntry* entries_begin = forward_entries_ + document.first_forward_entry;
+    const IndexSnapshotForwardEntry* entries_end = entries_begin + document.forward_entry_count;
+    // Returns nullptr unless the word is in the document
+    const auto find_in_document = [&](string_view word) -> const IndexSnapshotTerm* {
+        const IndexSnapshotTerm* term = FindTerm(word);
+        if (term == nullptr) {
+            return nullptr;
+        }
+        const uint64_t term_index = term - terms_;
+        const auto it = lower_bound(entries_begin, entries_end, term_index,
+            [](const IndexSnapshotForwardEntry& entry, uint64_t index) {
+                return entry.term_index < index;
+            });
+        return it != entries_end && it->term_index == term_index ? term : nullptr;
+    };
+
+    for (const string_view word : query.minus_words) {
+        if (find_in_document(word) != nullptr) {
+            return { vector<string_view>{}, status };
+        }
+    }
+    vector<string_view> matched_words;
+    for (const string_view word : query.plus_words) {
+        if (const IndexSnapshotTerm* term = find_in_document(word)) {
+            matched_words.push_back(GetString(term->word));
+        }
+    }
+    return { matched_words, status };
+}
+
+size_t MappedSearchServer::GetDocumentCount() const {
+    return header_->documents.count;
+}
+
+void MappedSearchServer::Validate() const {
+    const uint64_t document_count = header_->documents.count;
+    const uint64_t term_count = header_->terms.count;
+    for (uint64_t i = 0; i < document_count; ++i) {
+        const IndexSnapshotDocument& document = documents_[i];
+        CheckRange(document.first_forward_entry, document.forward_entry_count, header_->forward_entries.count);
+        if (document.status < static_cast<int32_t>(DocumentStatus::ACTUAL) || document.status > static_cast<int32_t>(DocumentStatus::REMOVED)) {
+            ThrowCorrupted();
+        }
+    }
+    for (uint64_t i = 0; i < header_->forward_entries.count; ++i) {
+        if (forward_entries_[i].term_index >= term_count) {
+            ThrowCorrupted();
+        }
+    }
+    for (uint64_t i = 0; i < term_count; ++i) {
+        const IndexSnapshotTerm& term = terms_[i];
+        CheckString(term.word, header_->strings.count);
+        CheckRange(term.first_block, term.block_count, header_->blocks.count);
+        if (term.posting_count == 0) {
+            ThrowCorrupted();
+        }
+    }
+    for (uint64_t i = 0; i < header_->blocks.count; ++i) {
+        const IndexSnapshotBlock& block = blocks_[i];
+        CheckRange(block.bytes_offset, block.bytes_length, header_->block_bytes.count);
+        CheckBlock(block_bytes_ + block.bytes_offset, block, document_count);
+    }
+}
+
+template <typename Record>
+const Record* MappedSearchServer::GetSection(const IndexSnapshotSection& section, size_t record_size) const {
+    if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > size_
+        || section.count > (size_ - section.offset) / record_size) {
+        ThrowCorrupted();
+    }
+    return reinterpret_cast<const Record*>(data_ + section.offset);
+}
+
+string_view MappedSearchServer::GetString(const IndexSnapshotString& string) const {
+    return { strings_ + string.offset, string.length };
+}
+
+const IndexSnapshotTerm* MappedSearchServer::FindTerm(string_view word) const {
+    const IndexSnapshotTerm* terms_end = terms_ + header_->terms.count;
+    const auto it = lower_bound(terms_, terms_end, word,
+        [this](const IndexSnapshotTerm& term, string_view value) {
+            return GetString(term.word) < value;
+        });
+    if (it == terms_end || GetString(it->word) != word) {
+        return nullptr;
+    }
+    return it;
+}
+
+const IndexSnapshotDocument& MappedSearchServer::GetDocument(int document_id) const {
+    const IndexSnapshotDocument* documents_end = documents_ + header_->documents.count;
+    const auto it = lower_bound(documents_, documents_end, document_id,
+        [](const IndexSnapshotDocument& document, int id) {
+            return document.id < id;
+        });
+    if (it == documents_end || it->id != document_id) {
+        throw out_of_range("документ с таким id не найден"s);
+    }
+    return *it;
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "document.h"
+#include "postings_list.h"
+#include "relevance_accumulator.h"
+#include "search_server.h"
+
+// Binary snapshot of a SearchServer. All sections are arrays of the records below,
+// 8-byte aligned, with offsets taken from the start of the file. Documents are sorted
+// by id and postings refer to documents by their position in that array. Terms are
+// sorted, so a term index orders words the same way as the words themselves
+const char INDEX_SNAPSHOT_MAGIC[8] = { 'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0' };
+const uint32_t INDEX_SNAPSHOT_VERSION = 2;
+
+struct IndexSnapshotSection {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct IndexSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    IndexSnapshotSection stop_words;
+    IndexSnapshotSection documents;
+    IndexSnapshotSection terms;
+    IndexSnapshotSection blocks;
+    IndexSnapshotSection forward_entries;
+    // Count is in bytes for the two raw sections
+    IndexSnapshotSection strings;
+    IndexSnapshotSection block_bytes;
+};
+
+struct IndexSnapshotString {
+    uint64_t offset;
+    uint64_t length;
+};
+
+struct IndexSnapshotDocument {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+    uint32_t forward_entry_count;
+    uint64_t first_forward_entry;
+    double inv_word_count;
+};
+
+struct IndexSnapshotTerm {
+    IndexSnapshotString word;
+    uint64_t first_block;
+    uint64_t block_count;
+    uint64_t posting_count;
+};
+
+// Same fields as PostingsList::Block, the offset points into the block bytes section
+struct IndexSnapshotBlock {
+    uint64_t first_ordinal;
+    uint64_t last_ordinal;
+    uint64_t bytes_offset;
+    uint32_t size;
+    uint32_t bytes_length;
+};
+
+// Term frequencies are not stored, only matching reads the forward entries
+struct IndexSnapshotForwardEntry {
+    uint64_t term_index;
+};
+
+// Replaces the file at path as a whole, servers which mapped the old one keep reading it
+void SaveIndexSnapshot(const SearchServer& search_server, const std::string& path);
+
+// Read-only search server answering queries straight from a memory-mapped snapshot.
+// Loading maps the file and checks in one pass that its records stay inside it,
+// queries then read the mapping directly. Processes mapping one file share its pages
+class MappedSearchServer {
+public:
+    explicit MappedSearchServer(const std::string& path);
+
+    MappedSearchServer(const MappedSearchServer&) = delete;
+    MappedSearchServer& operator=(const MappedSearchServer&) = delete;
+
+    ~MappedSearchServer();
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // Matched words are views into the mapped file
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    size_t GetDocumentCount() const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+
+    const IndexSnapshotHeader* header_ = nullptr;
+    const IndexSnapshotDocument* documents_ = nullptr;
+    const IndexSnapshotTerm* terms_ = nullptr;
+    const IndexSnapshotBlock* blocks_ = nullptr;
+    const IndexSnapshotForwardEntry* forward_entries_ = nullptr;
+    const char* strings_ = nullptr;
+    const uint8_t* block_bytes_ = nullptr;
+
+    // Holds only the stop words and parses queries exactly like the saved server
+    std::unique_ptr<SearchServer> query_parser_;
+
+    // Throws unless every offset, count and posting of the records stays inside the file
+    void Validate() const;
+
+    template <typename Record>
+    const Record* GetSection(const IndexSnapshotSection& section, size_t record_size = sizeof(Record)) const;
+
+    std::string_view GetString(const IndexSnapshotString& string) const;
+
+    // Returns nullptr for words which are not in the snapshot
+    const IndexSnapshotTerm* FindTerm(std::string_view word) const;
+
+    const IndexSnapshotDocument& GetDocument(int document_id) const;
+
+    template <typename Action>
+    void ForEachPosting(const IndexSnapshotTerm& term, Action action) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const SearchServer::Query& query, DocumentPredicate document_predicate) const;
+};
+
+    template <typename DocumentPredicate>
+    std::vector<Document> MappedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count) const {
+        QueryArena arena;
+        const SearchServer::Query query = query_parser_->ParseQuery(raw_query, arena.GetResource());
+        auto matched_documents = FindAllDocuments(query, document_predicate);
+        SearchServer::SelectTopDocuments(matched_documents, top_count);
+        return matched_documents;
+    }
+
+    template <typename Action>
+    void MappedSearchServer::ForEachPosting(const IndexSnapshotTerm& term, Action action) const {
+        for (uint64_t i = term.first_block; i < term.first_block + term.block_count; ++i) {
+            const IndexSnapshotBlock& block = blocks_[i];
+            PostingsList::DecodeBlock(block_bytes_ + block.bytes_offset, block.first_ordinal, block.size, action);
+        }
+    }
+
+    // Scores documents with the formulas of SearchServer, so results are the same
+    template <typename DocumentPredicate>
+    std::vector<Document> MappedSearchServer::FindAllDocuments(const SearchServer::Query& query, DocumentPredicate document_predicate) const {
+        QueryArena arena;
+        std::pmr::memory_resource* resource = arena.GetResource();
+        const size_t document_count = GetDocumentCount();
+        // Minus words are few and usually rare, their documents are masked before scoring
+        std::optional<DocumentBitmap> excluded_documents;
+        for (const std::string_view word : query.minus_words) {
+            if (const IndexSnapshotTerm* term = FindTerm(word)) {
+                if (!excluded_documents) {
+                    excluded_documents.emplace(document_count, resource);
+                }
+                ForEachPosting(*term, [&excluded_documents](size_t document_ordinal, uint32_t) {
+                    excluded_documents->Set(document_ordinal);
+                });
+            }
+        }
+        std::pmr::vector<const IndexSnapshotTerm*> plus_terms(resource);
+        size_t plus_posting_count = 0;
+        for (const std::string_view word : query.plus_words) {
+            if (const IndexSnapshotTerm* term = FindTerm(word)) {
+                plus_terms.push_back(term);
+                plus_posting_count += term->posting_count;
+            }
+        }
+
+        const auto find_all_documents = [&](auto& accumulator) {
+            for (const IndexSnapshotTerm* term : plus_terms) {
+                const double inverse_document_freq = std::log(document_count * 1.0 / term->posting_count);
+                ForEachPosting(*term, [&](size_t document_ordinal, uint32_t occurrences) {
+                    if (excluded_documents && excluded_documents->Test(document_ordinal)) {
+                        return;
+                    }
+                    const IndexSnapshotDocument& document = documents_[document_ordinal];
+                    if (document_predicate(document.id, static_cast<DocumentStatus>(document.status), document.rating)) {
+                        accumulator.Add(document_ordinal,
+                            SearchServer::ComputeTermFreq(occurrences, document.inv_word_count) * inverse_document_freq);
+                    }
+                });
+            }
+            std::vector<Document> matched_documents;
+            accumulator.ForEach([&](size_t document_ordinal, double relevance) {
+                const IndexSnapshotDocument& document = documents_[document_ordinal];
+                matched_documents.push_back({ document.id, relevance, document.rating });
+            });
+            return matched_documents;
+        };
+        // Same choice of accumulator as SearchServer makes
+        if (plus_posting_count * SearchServer::DENSE_ACCUMULATOR_RATIO >= document_count) {
+            DenseRelevanceAccumulator accumulator(document_count, resource);
+            return find_all_documents(accumulator);
+        }
+        HashRelevanceAccumulator accumulator(plus_posting_count, resource);
+        return find_all_documents(accumulator);
+    }
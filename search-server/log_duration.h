@@ -1 +1,39 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#define PROFILE_CONCAT_INTERNAL(X, Y) X##Y
+#define PROFILE_CONCAT(X, Y) PROFILE_CONCAT_INTERNAL(X, Y)
+#define UNIQUE_VAR_NAME_PROFILE PROFILE_CONCAT(profileGuard, __LINE__)
+#define LOG_DURATION(x) LogDuration UNIQUE_VAR_NAME_PROFILE(x)
+#define LOG_DURATION_STREAM(x, y) LogDuration UNIQUE_VAR_NAME_PROFILE(x, y)
+
+// Prints the time spent in its scope when destroyed
+class LogDuration {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit LogDuration(std::string_view id, std::ostream& output = std::cerr)
+        : id_(id)
+        , output_(output) {
+    }
+
+    LogDuration(const LogDuration&) = delete;
+    LogDuration& operator=(const LogDuration&) = delete;
+
+    ~LogDuration() {
+        using namespace std::chrono;
+        using namespace std::literals;
+
+        const auto duration = Clock::now() - start_time_;
+        output_ << id_ << ": "s << duration_cast<milliseconds>(duration).count() << " ms"s << std::endl;
+    }
+
+private:
+    const std::string id_;
+    std::ostream& output_;
+    const Clock::time_point start_time_ = Clock::now();
+};
@@ -3,6 +3,10 @@
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include "document.h"
 
 template <typename Iterator>
@@ -10,8 +14,7 @@ class IteratorRange {
 public:
     IteratorRange(Iterator begin, Iterator end)
         : first_(begin)
-        , last_(end)
-        , size_(distance(first_, last_)) {
+        , last_(end) {
     }
 
     Iterator begin() const {
@@ -22,13 +25,13 @@ public:
         return last_;
     }
 
+    // Counted on demand, constant time for random access iterators only
     size_t size() const {
-        return size_;
+        return std::distance(first_, last_);
     }
 
 private:
     Iterator first_, last_;
-    size_t size_;
 };
 
 
@@ -40,37 +43,165 @@ std::ostream& operator<<(std::ostream& os, const IteratorRange<Iterator>& range)
     return os;
 }
 
+// Pages are not stored, their bounds are found while iterating or, for random
+// access iterators, computed directly by GetPage
 template <typename Iterator>
 class Paginator {
 public:
-    Paginator(Iterator begin, Iterator end, size_t page_size) {
-        for (size_t left = distance(begin, end); left > 0;) {
-            const size_t current_page_size = std::min(page_size, left);
-            const Iterator current_page_end = next(begin, current_page_size);
-            pages_.push_back({ begin, current_page_end });
-
-            left -= current_page_size;
-            begin = current_page_end;
+    class PageIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = IteratorRange<Iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        PageIterator(Iterator page_begin, Iterator end, size_t page_size)
+            : page_(page_begin, AdvancePage(page_begin, end, page_size))
+            , end_(end)
+            , page_size_(page_size) {
+        }
+
+        reference operator*() const {
+            return page_;
+        }
+
+        pointer operator->() const {
+            return &page_;
+        }
+
+        PageIterator& operator++() {
+            page_ = { page_.end(), AdvancePage(page_.end(), end_, page_size_) };
+            return *this;
+        }
+
+        PageIterator operator++(int) {
+            PageIterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            return page_.begin() == other.page_.begin();
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        IteratorRange<Iterator> page_;
+        Iterator end_;
+        size_t page_size_;
+    };
+
+    Paginator(Iterator begin, Iterator end, size_t page_size)
+        : begin_(begin)
+        , end_(end)
+        , page_size_(page_size) {
+        if (page_size_ == 0) {
+            throw std::invalid_argument("размер страницы должен быть положительным");
         }
     }
 
-    auto begin() const {
-        return pages_.begin();
+    PageIterator begin() const {
+        return { begin_, end_, page_size_ };
     }
 
-    auto end() const {
-        return pages_.end();
+    PageIterator end() const {
+        return { end_, end_, page_size_ };
     }
 
+    // Constant time for random access iterators, otherwise walks the range
     size_t size() const {
-        return pages_.size();
+        return (std::distance(begin_, end_) + page_size_ - 1) / page_size_;
+    }
+
+    bool empty() const {
+        return begin_ == end_;
+    }
+
+    // Empty past the last page
+    IteratorRange<Iterator> GetPage(size_t page) const {
+        static_assert(std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>,
+            "GetPage needs random access iterators, iterate the pages instead");
+        if (page >= size()) {
+            return { end_, end_ };
+        }
+        const Iterator page_begin = begin_ + page * page_size_;
+        return { page_begin, AdvancePage(page_begin, end_, page_size_) };
     }
 
 private:
-    std::vector<IteratorRange<Iterator>> pages_;
+    Iterator begin_, end_;
+    size_t page_size_;
+
+    static Iterator AdvancePage(Iterator page_begin, Iterator end, size_t page_size) {
+        if constexpr (std::is_base_of_v<std::random_access_iterator_tag, typename std::iterator_traits<Iterator>::iterator_category>) {
+            return page_begin + std::min<size_t>(page_size, end - page_begin);
+        }
+        else {
+            for (size_t i = 0; i < page_size && page_begin != end; ++i) {
+                ++page_begin;
+            }
+            return page_begin;
+        }
+    }
 };
 
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
 }
+
+// Pages of a top-k search. The producer returns the top_count best results in order, e.g.
+//     [&](size_t top_count) { return search_server.FindTopDocuments(std::execution::seq, query, DocumentStatus::ACTUAL, top_count); }
+// Page n asks for the (n + 1) * page_size best results only, so results below it are not
+// sorted, and with pruned retrieval not even scored. A deeper page refetches at least twice
+// as many results as are kept, so paging through all of them costs a few full searches.
+// Like FindTopDocuments with another top_count, a refetch may order near ties differently
+template <typename TopProducer>
+class TopPaginator {
+public:
+    using Results = std::invoke_result_t<TopProducer&, size_t>;
+
+    TopPaginator(TopProducer producer, size_t page_size)
+        : producer_(std::move(producer))
+        , page_size_(page_size) {
+        if (page_size_ == 0) {
+            throw std::invalid_argument("размер страницы должен быть положительным");
+        }
+    }
+
+    // Empty past the last page
+    Results GetPage(size_t page) {
+        if (page >= std::numeric_limits<size_t>::max() / page_size_) {
+            return {};
+        }
+        Fetch((page + 1) * page_size_);
+        const size_t first = std::min(page * page_size_, results_.size());
+        const size_t last = std::min(first + page_size_, results_.size());
+        return Results(results_.begin() + first, results_.begin() + last);
+    }
+
+private:
+    TopProducer producer_;
+    size_t page_size_;
+    Results results_;
+    // The producer returned fewer results than asked, so there are no more
+    bool is_complete_ = false;
+
+    void Fetch(size_t top_count) {
+        if (is_complete_ || results_.size() >= top_count) {
+            return;
+        }
+        top_count = std::max(top_count, 2 * results_.size());
+        results_ = producer_(top_count);
+        is_complete_ = results_.size() < top_count;
+    }
+};
+
+template <typename TopProducer>
+auto PaginateTop(TopProducer producer, size_t page_size) {
+    return TopPaginator<TopProducer>(std::move(producer), page_size);
+}
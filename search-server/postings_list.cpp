@@ -0,0 +1,201 @@
+#include "postings_list.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void PostingsList::Append(size_t document_ordinal, uint32_t occurrences) {
+    // Two varints of at most ten bytes each
+    ReserveBytes(20);
+    if (blocks_.empty() || blocks_.back().size == BLOCK_SIZE) {
+        Block& block = blocks_.emplace_back();
+        block.first_ordinal = document_ordinal;
+        block.last_ordinal = document_ordinal;
+        block.bytes_offset = static_cast<uint32_t>(bytes_.size());
+    }
+    // The last block ends the buffer, so its bytes stay contiguous
+    Block& block = blocks_.back();
+    const size_t byte_count = bytes_.size();
+    WriteVarint(bytes_, document_ordinal - block.last_ordinal);
+    WriteVarint(bytes_, occurrences);
+    block.byte_count += static_cast<uint16_t>(bytes_.size() - byte_count);
+    block.last_ordinal = document_ordinal;
+    ++block.size;
+    ++size_;
+}
+
+void PostingsList::Erase(size_t document_ordinal) {
+    const auto found = FindBlock(document_ordinal);
+    if (found == blocks_.end() || found->first_ordinal > document_ordinal) {
+        return;
+    }
+    const auto block = blocks_.begin() + (found - blocks_.cbegin());
+    vector<pair<size_t, uint32_t>> postings;
+    postings.reserve(block->size);
+    ForEach(*block, [&postings, document_ordinal](size_t ordinal, uint32_t occurrences) {
+        if (ordinal != document_ordinal) {
+            postings.push_back({ ordinal, occurrences });
+        }
+    });
+    if (postings.size() == block->size) {
+        return;
+    }
+    --size_;
+    free_byte_count_ += block->byte_count;
+    if (postings.empty()) {
+        blocks_.erase(block);
+    }
+    else {
+        Encode(*block, postings);
+        free_byte_count_ -= block->byte_count;
+    }
+    // Appends continue the last block, so nothing may follow it
+    const size_t size = blocks_.empty() ? 0 : blocks_.back().bytes_offset + blocks_.back().byte_count;
+    free_byte_count_ -= static_cast<uint32_t>(bytes_.size() - size);
+    bytes_.resize(size);
+    if (static_cast<size_t>(free_byte_count_) * 2 > bytes_.size()) {
+        CompactBytes();
+    }
+}
+
+bool PostingsList::Contains(size_t document_ordinal) const {
+    const auto block = FindBlock(document_ordinal);
+    if (block == blocks_.end() || block->first_ordinal > document_ordinal) {
+        return false;
+    }
+    bool found = false;
+    ForEach(*block, [&found, document_ordinal](size_t ordinal, uint32_t) {
+        found = found || ordinal == document_ordinal;
+    });
+    return found;
+}
+
+PostingsList::Cursor::Cursor(const PostingsList& postings)
+    : bytes_(postings.bytes_.data())
+    , block_(postings.blocks_.begin())
+    , blocks_end_(postings.blocks_.end())
+{
+    LoadBlock();
+}
+
+bool PostingsList::Cursor::AtEnd() const {
+    return block_ == blocks_end_;
+}
+
+size_t PostingsList::Cursor::GetOrdinal() const {
+    return ordinals_[position_];
+}
+
+uint32_t PostingsList::Cursor::GetOccurrences() const {
+    return occurrences_[position_];
+}
+
+void PostingsList::Cursor::Next() {
+    if (++position_ == block_->size) {
+        ++block_;
+        LoadBlock();
+    }
+}
+
+void PostingsList::Cursor::SkipTo(size_t document_ordinal) {
+    if (AtEnd() || GetOrdinal() >= document_ordinal) {
+        return;
+    }
+    if (block_->last_ordinal < document_ordinal) {
+        block_ = lower_bound(next(block_), blocks_end_, document_ordinal,
+            [](const Block& block, size_t ordinal) {
+                return block.last_ordinal < ordinal;
+            });
+        LoadBlock();
+        if (AtEnd()) {
+            return;
+        }
+    }
+    while (ordinals_[position_] < document_ordinal) {
+        ++position_;
+    }
+}
+
+void PostingsList::Cursor::LoadBlock() {
+    position_ = 0;
+    if (AtEnd()) {
+        return;
+    }
+    uint32_t index = 0;
+    DecodeBlock(bytes_ + block_->bytes_offset, block_->first_ordinal, block_->size, [this, &index](size_t ordinal, uint32_t occurrences) {
+        ordinals_[index] = ordinal;
+        occurrences_[index] = occurrences;
+        ++index;
+    });
+}
+
+const vector<PostingsList::Block>& PostingsList::GetBlocks() const {
+    return blocks_;
+}
+
+const uint8_t* PostingsList::GetBlockBytes(const Block& block) const {
+    return bytes_.data() + block.bytes_offset;
+}
+
+size_t PostingsList::size() const {
+    return size_;
+}
+
+bool PostingsList::empty() const {
+    return size_ == 0;
+}
+
+size_t PostingsList::GetMemoryUsage() const {
+    return sizeof(*this) + blocks_.capacity() * sizeof(Block) + bytes_.capacity();
+}
+
+void PostingsList::WriteVarint(vector<uint8_t>& bytes, uint64_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+void PostingsList::ReserveBytes(size_t byte_count) {
+    if (bytes_.size() + byte_count > bytes_.capacity()) {
+        bytes_.reserve(bytes_.size() + max(byte_count, bytes_.size() / 4));
+    }
+}
+
+void PostingsList::Encode(Block& block, const vector<pair<size_t, uint32_t>>& postings) {
+    vector<uint8_t> bytes;
+    block.first_ordinal = postings.front().first;
+    block.last_ordinal = block.first_ordinal;
+    block.size = 0;
+    for (const auto& [ordinal, occurrences] : postings) {
+        WriteVarint(bytes, ordinal - block.last_ordinal);
+        WriteVarint(bytes, occurrences);
+        block.last_ordinal = ordinal;
+        ++block.size;
+    }
+    copy(bytes.begin(), bytes.end(), bytes_.begin() + block.bytes_offset);
+    block.byte_count = static_cast<uint16_t>(bytes.size());
+}
+
+void PostingsList::CompactBytes() {
+    // Blocks lie in order, so every one moves towards the front
+    size_t size = 0;
+    for (Block& block : blocks_) {
+        if (block.bytes_offset != size) {
+            copy_n(bytes_.begin() + block.bytes_offset, block.byte_count, bytes_.begin() + size);
+            block.bytes_offset = static_cast<uint32_t>(size);
+        }
+        size += block.byte_count;
+    }
+    bytes_.resize(size);
+    bytes_.shrink_to_fit();
+    free_byte_count_ = 0;
+}
+
+vector<PostingsList::Block>::const_iterator PostingsList::FindBlock(size_t document_ordinal) const {
+    return lower_bound(blocks_.begin(), blocks_.end(), document_ordinal,
+        [](const Block& block, size_t ordinal) {
+            return block.last_ordinal < ordinal;
+        });
+}
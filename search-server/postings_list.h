@@ -0,0 +1,140 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Postings of one term: increasing document ordinals with the number of occurrences
+// of the term in the document. Postings are grouped into blocks of at most BLOCK_SIZE.
+// Inside a block every posting is two varints: the ordinal delta from the previous
+// posting (from first_ordinal for the first one) and the occurrences. The first and
+// last ordinals of each block act as skip pointers, so lookups decode a single block.
+// The bytes of all blocks lie in one buffer in block order, a block refers to its range.
+// Erasing a posting re-encodes its block in place and leaves the freed bytes as a hole,
+// holes are squeezed out once they take half of the buffer
+class PostingsList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    struct Block {
+        size_t first_ordinal = 0;
+        size_t last_ordinal = 0;
+        // A list takes a few bytes per posting, far from the 4 GiB an offset can address
+        uint32_t bytes_offset = 0;
+        uint16_t size = 0;
+        uint16_t byte_count = 0;
+    };
+
+    // Reads the postings in order a block at a time. Blocks ending before the
+    // requested ordinal are skipped without decoding
+    class Cursor {
+    public:
+        explicit Cursor(const PostingsList& postings);
+
+        bool AtEnd() const;
+
+        size_t GetOrdinal() const;
+
+        uint32_t GetOccurrences() const;
+
+        void Next();
+
+        // Moves to the first posting with an ordinal not less than document_ordinal
+        void SkipTo(size_t document_ordinal);
+
+    private:
+        const uint8_t* bytes_;
+        std::vector<Block>::const_iterator block_;
+        std::vector<Block>::const_iterator blocks_end_;
+        std::array<size_t, BLOCK_SIZE> ordinals_;
+        std::array<uint32_t, BLOCK_SIZE> occurrences_;
+        uint32_t position_ = 0;
+
+        void LoadBlock();
+    };
+
+    // document_ordinal must be greater than every ordinal already in the list
+    void Append(size_t document_ordinal, uint32_t occurrences);
+
+    void Erase(size_t document_ordinal);
+
+    bool Contains(size_t document_ordinal) const;
+
+    template <typename Action>
+    void ForEach(Action action) const;
+
+    // Calls action(document_ordinal, occurrences) for every posting of a block of the list
+    template <typename Action>
+    void ForEach(const Block& block, Action action) const;
+
+    const std::vector<Block>& GetBlocks() const;
+
+    const uint8_t* GetBlockBytes(const Block& block) const;
+
+    // Decodes a block stored elsewhere, e.g. in an index snapshot
+    template <typename Action>
+    static void DecodeBlock(const uint8_t* data, size_t first_ordinal, uint32_t size, Action action);
+
+    size_t size() const;
+
+    bool empty() const;
+
+    // Heap and object bytes taken by the list
+    size_t GetMemoryUsage() const;
+
+private:
+    std::vector<Block> blocks_;
+    std::vector<uint8_t> bytes_;
+    // Bytes of the buffer between blocks, left by erased postings
+    uint32_t free_byte_count_ = 0;
+    // Document ids are ints, so a term has fewer than 2^31 postings
+    uint32_t size_ = 0;
+
+    static void WriteVarint(std::vector<uint8_t>& bytes, uint64_t value);
+
+    // Makes room for a posting at the end of the buffer, growing it by a quarter at least
+    // so that a long list does not keep up to half of its bytes spare
+    void ReserveBytes(size_t byte_count);
+
+    // Rewrites the postings of the block into its own range, they take no more bytes than before
+    void Encode(Block& block, const std::vector<std::pair<size_t, uint32_t>>& postings);
+
+    // Moves the blocks to the front of the buffer, dropping the holes between them
+    void CompactBytes();
+
+    // First block whose last ordinal is not less than document_ordinal
+    std::vector<Block>::const_iterator FindBlock(size_t document_ordinal) const;
+};
+
+    template <typename Action>
+    void PostingsList::ForEach(const Block& block, Action action) const {
+        DecodeBlock(GetBlockBytes(block), block.first_ordinal, block.size, action);
+    }
+
+    template <typename Action>
+    void PostingsList::DecodeBlock(const uint8_t* data, size_t first_ordinal, uint32_t size, Action action) {
+        size_t document_ordinal = first_ordinal;
+        const auto read_varint = [&data]() {
+            uint64_t value = 0;
+            for (int shift = 0;; shift += 7) {
+                const uint8_t byte = *data++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+        };
+        for (uint32_t i = 0; i < size; ++i) {
+            document_ordinal += read_varint();
+            const uint32_t occurrences = static_cast<uint32_t>(read_varint());
+            action(document_ordinal, occurrences);
+        }
+    }
+
+    template <typename Action>
+    void PostingsList::ForEach(Action action) const {
+        for (const Block& block : blocks_) {
+            ForEach(block, action);
+        }
+    }
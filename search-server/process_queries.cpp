@@ -0,0 +1,102 @@
+#include "process_queries.h"
+
+#include <algorithm>
+#include <exception>
+#include <execution>
+#include <functional>
+#include <numeric>
+
+using namespace std;
+
+JoinedDocuments::Iterator::Iterator(const vector<vector<Document>>& results, size_t query_index)
+    : results_(&results)
+    , query_index_(query_index)
+{
+    SkipEmptyResults();
+}
+
+JoinedDocuments::Iterator::reference JoinedDocuments::Iterator::operator*() const {
+    return (*results_)[query_index_][document_index_];
+}
+
+JoinedDocuments::Iterator::pointer JoinedDocuments::Iterator::operator->() const {
+    return &**this;
+}
+
+JoinedDocuments::Iterator& JoinedDocuments::Iterator::operator++() {
+    ++document_index_;
+    SkipEmptyResults();
+    return *this;
+}
+
+JoinedDocuments::Iterator JoinedDocuments::Iterator::operator++(int) {
+    Iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool JoinedDocuments::Iterator::operator==(const Iterator& other) const {
+    return results_ == other.results_
+        && query_index_ == other.query_index_
+        && document_index_ == other.document_index_;
+}
+
+bool JoinedDocuments::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+void JoinedDocuments::Iterator::SkipEmptyResults() {
+    while (query_index_ < results_->size() && document_index_ == (*results_)[query_index_].size()) {
+        ++query_index_;
+        document_index_ = 0;
+    }
+}
+
+JoinedDocuments::JoinedDocuments(vector<vector<Document>> results)
+    : results_(move(results))
+{
+}
+
+JoinedDocuments::Iterator JoinedDocuments::begin() const {
+    return Iterator(results_, 0);
+}
+
+JoinedDocuments::Iterator JoinedDocuments::end() const {
+    return Iterator(results_, results_.size());
+}
+
+size_t JoinedDocuments::size() const {
+    return transform_reduce(results_.begin(), results_.end(), size_t{ 0 }, plus<>{},
+        [](const vector<Document>& documents) {
+            return documents.size();
+        });
+}
+
+vector<vector<Document>> ProcessQueries(const SearchServer& search_server, const vector<string>& queries) {
+    // Queries are independent tasks, the parallel scheduler balances costly ones between threads
+    // An exception escaping a parallel algorithm terminates the program, so errors are kept
+    // per query and the one of the first failed query is rethrown afterwards
+    vector<vector<Document>> result(queries.size());
+    vector<exception_ptr> errors(queries.size());
+    vector<size_t> query_indexes(queries.size());
+    iota(query_indexes.begin(), query_indexes.end(), 0);
+    for_each(execution::par, query_indexes.begin(), query_indexes.end(),
+        [&](size_t i) {
+            try {
+                result[i] = search_server.FindTopDocuments(queries[i]);
+            }
+            catch (...) {
+                errors[i] = current_exception();
+            }
+        });
+    for (const exception_ptr& error : errors) {
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+    return result;
+}
+
+JoinedDocuments ProcessQueriesJoined(const SearchServer& search_server, const vector<string>& queries) {
+    return JoinedDocuments(ProcessQueries(search_server, queries));
+}
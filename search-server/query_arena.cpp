@@ -0,0 +1,24 @@
+#include "query_arena.h"
+
+using namespace std;
+
+QueryArena::QueryArena()
+    : state_(GetThreadState())
+{
+    ++state_.depth;
+}
+
+QueryArena::~QueryArena() {
+    if (--state_.depth == 0) {
+        state_.resource.release();
+    }
+}
+
+pmr::memory_resource* QueryArena::GetResource() const {
+    return &state_.resource;
+}
+
+QueryArena::ThreadState& QueryArena::GetThreadState() {
+    thread_local ThreadState state;
+    return state;
+}
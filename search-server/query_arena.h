@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// Scratch memory of the queries running on the current thread. Scopes nest, and
+// everything allocated from the arena is released at once when the outermost scope
+// of the thread ends, so objects using it must not outlive their scope
+class QueryArena {
+public:
+    QueryArena();
+
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    ~QueryArena();
+
+    std::pmr::memory_resource* GetResource() const;
+
+private:
+    // Typical queries fit into the buffer, larger ones borrow from the heap until released
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    struct ThreadState {
+        std::unique_ptr<std::byte[]> buffer = std::make_unique<std::byte[]>(BUFFER_SIZE);
+        std::pmr::monotonic_buffer_resource resource{ buffer.get(), BUFFER_SIZE };
+        size_t depth = 0;
+    };
+
+    ThreadState& state_;
+
+    static ThreadState& GetThreadState();
+};
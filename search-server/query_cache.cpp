@@ -0,0 +1,152 @@
+#include "query_cache.h"
+
+#include <execution>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+QueryCache::QueryCache(const SearchServer& search_server, size_t capacity, size_t shard_count)
+    : search_server_(search_server)
+    , set_count_((capacity + WAYS - 1) / WAYS)
+    , slots_(set_count_ * WAYS)
+    , clock_hands_(set_count_, 0)
+    , shards_(shard_count)
+{
+    if (capacity == 0 || shard_count == 0) {
+        throw invalid_argument("ёмкость кэша и количество шардов должны быть положительными"s);
+    }
+}
+
+QueryCache::~QueryCache() {
+    for (const atomic<const Entry*>& slot : slots_) {
+        delete slot.load(memory_order_relaxed);
+    }
+    for (const Shard& shard : shards_) {
+        for (const auto& [phase, entry] : shard.retired_entries) {
+            delete entry;
+        }
+    }
+}
+
+vector<Document> QueryCache::FindTopDocuments(string_view raw_query, DocumentStatus status) {
+    QueryArena arena;
+    const SearchServer::Query query = search_server_.ParseQuery(raw_query, arena.GetResource());
+    string key = MakeKey(query, status);
+    const uint64_t generation = search_server_.GetGeneration();
+    const size_t set_index = hash<string>{}(key) % set_count_;
+    Shard& shard = shards_[set_index % shards_.size()];
+    {
+        ReadGuard guard(shard);
+        for (size_t way = 0; way < WAYS; ++way) {
+            const Entry* entry = slots_[set_index * WAYS + way].load(memory_order_seq_cst);
+            if (entry != nullptr && entry->generation == generation && entry->key == key) {
+                entry->is_referenced.store(true, memory_order_relaxed);
+                shard.hits.fetch_add(1, memory_order_relaxed);
+                return entry->documents;
+            }
+        }
+    }
+    shard.misses.fetch_add(1, memory_order_relaxed);
+
+    auto entry = make_unique<Entry>();
+    entry->key = move(key);
+    entry->generation = generation;
+    {
+        SEARCH_METRICS_STAGE(SearchStage::FIND_TOP_DOCUMENTS);
+        entry->documents = search_server_.FindTopDocuments(execution::seq, query, DocumentStatusPredicate{ status },
+            MAX_RESULT_DOCUMENT_COUNT);
+    }
+    vector<Document> documents = entry->documents;
+    Insert(set_index, entry.release());
+    return documents;
+}
+
+vector<Document> QueryCache::FindTopDocuments(string_view raw_query) {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+QueryCacheStats QueryCache::GetStats() const {
+    QueryCacheStats stats;
+    for (const Shard& shard : shards_) {
+        stats.hits += shard.hits.load(memory_order_relaxed);
+        stats.misses += shard.misses.load(memory_order_relaxed);
+    }
+    return stats;
+}
+
+string QueryCache::MakeKey(const SearchServer::Query& query, DocumentStatus status) {
+    // Words contain no spaces, so the key is unambiguous
+    string key(1, static_cast<char>(status));
+    for (const string_view word : query.plus_words) {
+        key += ' ';
+        key += word;
+    }
+    for (const string_view word : query.minus_words) {
+        key += " -"s;
+        key += word;
+    }
+    return key;
+}
+
+void QueryCache::Insert(size_t set_index, const Entry* entry) {
+    Shard& shard = shards_[set_index % shards_.size()];
+    lock_guard guard(shard.mutex);
+    atomic<const Entry*>* set = &slots_[set_index * WAYS];
+    // An entry of the same query or an outdated one is replaced first
+    size_t way = 0;
+    for (; way < WAYS; ++way) {
+        const Entry* current = set[way].load(memory_order_relaxed);
+        if (current == nullptr || current->key == entry->key || current->generation != entry->generation) {
+            break;
+        }
+    }
+    if (way == WAYS) {
+        // The hand skips recently used entries, clearing their marks, and evicts the first unused one
+        uint8_t& hand = clock_hands_[set_index];
+        while (set[hand].load(memory_order_relaxed)->is_referenced.exchange(false, memory_order_relaxed)) {
+            hand = (hand + 1) % WAYS;
+        }
+        way = hand;
+        hand = (hand + 1) % WAYS;
+    }
+    if (const Entry* replaced = set[way].exchange(entry, memory_order_seq_cst)) {
+        Retire(shard, replaced);
+    }
+}
+
+void QueryCache::Retire(Shard& shard, const Entry* entry) {
+    const uint64_t phase = shard.phase.load(memory_order_relaxed);
+    shard.retired_entries.push_back({ phase, entry });
+    if (shard.readers[(phase + 1) % 2].load(memory_order_seq_cst) == 0) {
+        shard.phase.store(phase + 1, memory_order_seq_cst);
+    }
+    const uint64_t current_phase = shard.phase.load(memory_order_relaxed);
+    auto& retired_entries = shard.retired_entries;
+    auto it = retired_entries.begin();
+    for (; it != retired_entries.end() && it->first + 2 <= current_phase; ++it) {
+        delete it->second;
+    }
+    retired_entries.erase(retired_entries.begin(), it);
+}
+
+QueryCache::ReadGuard::ReadGuard(Shard& shard)
+    : shard_(shard)
+{
+    // A phase which changed before the registration became visible may already be
+    // treated as drained, so the reader registers again under the new one
+    while (true) {
+        const uint64_t phase = shard_.phase.load(memory_order_seq_cst);
+        parity_ = phase % 2;
+        shard_.readers[parity_].fetch_add(1, memory_order_seq_cst);
+        if (shard_.phase.load(memory_order_seq_cst) == phase) {
+            break;
+        }
+        shard_.readers[parity_].fetch_sub(1, memory_order_seq_cst);
+    }
+}
+
+QueryCache::ReadGuard::~ReadGuard() {
+    shard_.readers[parity_].fetch_sub(1, memory_order_seq_cst);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Results of repeated FindTopDocuments calls. Queries are keyed by their parsed form,
+// so word order and repeated words do not matter, together with the status filter.
+// Entries found before the last change of the server are never returned.
+// Entries are grouped into sets of WAYS and evicted in CLOCK order, an approximation
+// of LRU which lets lookups mark entries as used without taking a lock. Hits take no
+// lock either, misses lock the shard of the set they insert into.
+// Lookups may run concurrently, but not with modifications of the server
+class QueryCache {
+public:
+    QueryCache(const SearchServer& search_server, size_t capacity, size_t shard_count = 16);
+
+    QueryCache(const QueryCache&) = delete;
+    QueryCache& operator=(const QueryCache&) = delete;
+
+    ~QueryCache();
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status);
+    std::vector<Document> FindTopDocuments(std::string_view raw_query);
+
+    QueryCacheStats GetStats() const;
+
+private:
+    static constexpr size_t WAYS = 8;
+
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+        // Set by lookups, cleared by the CLOCK hand passing by
+        mutable std::atomic<bool> is_referenced{ true };
+    };
+
+    // Writers of the sets of a shard take its mutex, readers only count themselves.
+    // An entry replaced at phase p is deleted once the phase reaches p + 2. The phase
+    // advances only when no reader registered under the other parity is left, so by
+    // then every reader which could have loaded the entry has finished
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+        std::atomic<uint64_t> phase{ 0 };
+        // Readers in progress by the parity of the phase they registered at
+        std::atomic<int64_t> readers[2] = { 0, 0 };
+        // Replaced entries with their phases in increasing order, guarded by the mutex
+        std::vector<std::pair<uint64_t, const Entry*>> retired_entries;
+    };
+
+    // Registers a lookup with its shard for its lifetime
+    class ReadGuard {
+    public:
+        explicit ReadGuard(Shard& shard);
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard();
+
+    private:
+        Shard& shard_;
+        size_t parity_;
+    };
+
+    const SearchServer& search_server_;
+    size_t set_count_;
+    std::vector<std::atomic<const Entry*>> slots_;
+    // CLOCK hand of every set, guarded by the mutex of its shard
+    std::vector<uint8_t> clock_hands_;
+    std::vector<Shard> shards_;
+
+    static std::string MakeKey(const SearchServer::Query& query, DocumentStatus status);
+
+    // Takes ownership of entry
+    void Insert(size_t set_index, const Entry* entry);
+
+    // Called under the mutex of the shard
+    static void Retire(Shard& shard, const Entry* entry);
+};
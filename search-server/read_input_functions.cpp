@@ -1,6 +1,207 @@
 #include "read_input_functions.h"
+
+#include <charconv>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace std;
 
+namespace {
+
+// Text is read and parsed in chunks large enough for sequential reads at disk speed
+const size_t CORPUS_CHUNK_BYTES = 4 << 20;
+const size_t CORPUS_QUEUE_CAPACITY = 8;
+
+struct CorpusBatch {
+    // Text of the records when it is not mapped, the documents refer to it
+    shared_ptr<const vector<char>> storage;
+    vector<NewDocument> documents;
+};
+
+// Queue between the parsing thread and the indexing one. Closing it wakes both sides
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity)
+        : capacity_(capacity) {
+    }
+
+    // Returns false when the queue was closed
+    bool Push(T value) {
+        unique_lock lock(mutex_);
+        not_full_.wait(lock, [this] {
+            return is_closed_ || items_.size() < capacity_;
+        });
+        if (is_closed_) {
+            return false;
+        }
+        items_.push_back(move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Returns nothing once the queue is closed and drained
+    optional<T> Pop() {
+        unique_lock lock(mutex_);
+        not_empty_.wait(lock, [this] {
+            return is_closed_ || !items_.empty();
+        });
+        if (items_.empty()) {
+            return nullopt;
+        }
+        T value = move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return value;
+    }
+
+    void Close() {
+        lock_guard guard(mutex_);
+        is_closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const size_t capacity_;
+    mutex mutex_;
+    condition_variable not_empty_;
+    condition_variable not_full_;
+    deque<T> items_;
+    bool is_closed_ = false;
+};
+
+class CorpusParser {
+public:
+    // Appends a document for every line of text, which must end with a complete line
+    void ParseLines(string_view text, vector<NewDocument>& documents) {
+        while (!text.empty()) {
+            const char* line_end = static_cast<const char*>(memchr(text.data(), '\n', text.size()));
+            const size_t line_size = line_end == nullptr ? text.size() : line_end - text.data();
+            string_view line = text.substr(0, line_size);
+            text.remove_prefix(min(line_size + 1, text.size()));
+            ++line_number_;
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (!line.empty()) {
+                documents.push_back(ParseRecord(line));
+            }
+        }
+    }
+
+private:
+    size_t line_number_ = 0;
+
+    NewDocument ParseRecord(string_view line) const {
+        const auto next_field = [&]() {
+            const size_t tab = line.find('\t');
+            if (tab == line.npos) {
+                ThrowInvalidRecord();
+            }
+            const string_view field = line.substr(0, tab);
+            line.remove_prefix(tab + 1);
+            return field;
+        };
+        NewDocument document{ ParseNumber(next_field()), {}, ParseStatus(next_field()), {} };
+        ForEachWord(next_field(), [&](string_view rating) {
+            document.ratings.push_back(ParseNumber(rating));
+        });
+        document.text = line;
+        return document;
+    }
+
+    int ParseNumber(string_view field) const {
+        int value = 0;
+        const auto [end, error] = from_chars(field.data(), field.data() + field.size(), value);
+        if (error != errc{} || end != field.data() + field.size()) {
+            ThrowInvalidRecord();
+        }
+        return value;
+    }
+
+    DocumentStatus ParseStatus(string_view field) const {
+        if (field == "ACTUAL"sv) {
+            return DocumentStatus::ACTUAL;
+        }
+        if (field == "IRRELEVANT"sv) {
+            return DocumentStatus::IRRELEVANT;
+        }
+        if (field == "BANNED"sv) {
+            return DocumentStatus::BANNED;
+        }
+        if (field == "REMOVED"sv) {
+            return DocumentStatus::REMOVED;
+        }
+        const int status = ParseNumber(field);
+        if (status < static_cast<int>(DocumentStatus::ACTUAL) || status > static_cast<int>(DocumentStatus::REMOVED)) {
+            ThrowInvalidRecord();
+        }
+        return static_cast<DocumentStatus>(status);
+    }
+
+    [[noreturn]] void ThrowInvalidRecord() const {
+        throw invalid_argument("неверная запись корпуса в строке "s + to_string(line_number_));
+    }
+};
+
+// Pushes the documents parsed from a chunk as one batch. Returns false when the pipeline stopped
+template <typename Push>
+bool PushDocuments(const Push& push, const shared_ptr<const vector<char>>& storage, vector<NewDocument>& documents) {
+    return documents.empty() || push(CorpusBatch{ storage, move(documents) });
+}
+
+// Runs produce(push) in a separate thread and indexes the batches it pushes as they come.
+// push returns false when the producer should stop
+template <typename Producer>
+vector<AddDocumentError> RunCorpusPipeline(SearchServer& search_server, Producer produce) {
+    BoundedQueue<CorpusBatch> queue(CORPUS_QUEUE_CAPACITY);
+    exception_ptr producer_error;
+    thread producer([&] {
+        try {
+            produce([&queue](CorpusBatch&& batch) {
+                return queue.Push(move(batch));
+            });
+        }
+        catch (...) {
+            producer_error = current_exception();
+        }
+        queue.Close();
+    });
+
+    vector<AddDocumentError> errors;
+    try {
+        while (optional<CorpusBatch> batch = queue.Pop()) {
+            vector<AddDocumentError> batch_errors = search_server.AddDocuments(batch->documents);
+            errors.insert(errors.end(), make_move_iterator(batch_errors.begin()), make_move_iterator(batch_errors.end()));
+        }
+    }
+    catch (...) {
+        queue.Close();
+        producer.join();
+        throw;
+    }
+    producer.join();
+    if (producer_error) {
+        rethrow_exception(producer_error);
+    }
+    return errors;
+}
+
+}  // namespace
+
 string ReadLine() {
     string s;
     getline(cin, s);
@@ -12,4 +213,88 @@ int ReadLineWithNumber() {
     cin >> result;
     ReadLine();
     return result;
-}
\ No newline at end of file
+}
+
+vector<AddDocumentError> LoadCorpus(SearchServer& search_server, const string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("не удалось открыть корпус "s + path);
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw runtime_error("не удалось открыть корпус "s + path);
+    }
+    // Pipes and devices cannot be mapped, they are read as streams
+    if (!S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        ifstream input(path, ios::binary);
+        return LoadCorpus(search_server, input);
+    }
+    const size_t size = file_stat.st_size;
+    if (size == 0) {
+        close(fd);
+        return {};
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw runtime_error("не удалось отобразить корпус "s + path);
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    // Records are views into the mapping, which outlives the pipeline
+    const string_view text(static_cast<const char*>(data), size);
+    try {
+        auto errors = RunCorpusPipeline(search_server, [text](const auto& push) {
+            CorpusParser parser;
+            vector<NewDocument> documents;
+            for (size_t begin = 0; begin < text.size();) {
+                size_t end = min(begin + CORPUS_CHUNK_BYTES, text.size());
+                const size_t line_end = text.find('\n', end - 1);
+                end = line_end == text.npos ? text.size() : line_end + 1;
+                documents.clear();
+                parser.ParseLines(text.substr(begin, end - begin), documents);
+                if (!PushDocuments(push, nullptr, documents)) {
+                    return;
+                }
+                begin = end;
+            }
+        });
+        munmap(data, size);
+        return errors;
+    }
+    catch (...) {
+        munmap(data, size);
+        throw;
+    }
+}
+
+vector<AddDocumentError> LoadCorpus(SearchServer& search_server, istream& input) {
+    return RunCorpusPipeline(search_server, [&input](const auto& push) {
+        CorpusParser parser;
+        // Incomplete last line of a read, moved to the next batch
+        vector<char> tail;
+        bool is_at_end = false;
+        vector<NewDocument> documents;
+        while (!is_at_end) {
+            auto storage = make_shared<vector<char>>();
+            storage->swap(tail);
+            const size_t kept_size = storage->size();
+            storage->resize(kept_size + CORPUS_CHUNK_BYTES);
+            input.read(storage->data() + kept_size, CORPUS_CHUNK_BYTES);
+            storage->resize(kept_size + input.gcount());
+            is_at_end = !input;
+
+            const string_view text(storage->data(), storage->size());
+            const size_t last_line_end = text.rfind('\n');
+            const size_t complete_size = is_at_end ? text.size() : (last_line_end == text.npos ? 0 : last_line_end + 1);
+            tail.assign(storage->begin() + complete_size, storage->end());
+            documents.clear();
+            parser.ParseLines(text.substr(0, complete_size), documents);
+            if (!PushDocuments(push, storage, documents)) {
+                return;
+            }
+        }
+    });
+}
@@ -1,7 +1,19 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <vector>
+
+#include "search_server.h"
 
 std::string ReadLine();
 
-int ReadLineWithNumber();
\ No newline at end of file
+int ReadLineWithNumber();
+
+// Corpus files hold a record per line: id, status, ratings and text separated by tabs.
+// The status is a number or a name such as BANNED, ratings are separated by spaces.
+// Records are parsed in place from large reads in one thread while the server indexes
+// the previous batch with AddDocuments, whose rejections are returned.
+// A malformed record throws std::invalid_argument, the batches before it stay indexed
+std::vector<AddDocumentError> LoadCorpus(SearchServer& search_server, const std::string& path);
+
+std::vector<AddDocumentError> LoadCorpus(SearchServer& search_server, std::istream& input);
@@ -0,0 +1,71 @@
+#include "relevance_accumulator.h"
+
+using namespace std;
+
+DocumentBitmap::DocumentBitmap(size_t document_count, pmr::memory_resource* resource)
+    : words_((document_count + 63) / 64, 0, resource)
+{
+}
+
+void DocumentBitmap::Set(size_t document_ordinal) {
+    words_[document_ordinal / 64] |= uint64_t{ 1 } << (document_ordinal % 64);
+}
+
+bool DocumentBitmap::Test(size_t document_ordinal) const {
+    return (words_[document_ordinal / 64] >> (document_ordinal % 64)) & 1;
+}
+
+DenseRelevanceAccumulator::DenseRelevanceAccumulator(size_t document_count, pmr::memory_resource* resource)
+    : relevances_(document_count, 0.0, resource)
+    , touched_(document_count, 0, resource)
+{
+}
+
+void DenseRelevanceAccumulator::Add(size_t document_ordinal, double relevance) {
+    touched_[document_ordinal] = 1;
+    relevances_[document_ordinal] += relevance;
+}
+
+HashRelevanceAccumulator::HashRelevanceAccumulator(size_t expected_count, pmr::memory_resource* resource)
+    : slots_(resource)
+{
+    // Load factor stays at most one half
+    size_t capacity = 16;
+    while (capacity < 2 * expected_count) {
+        capacity *= 2;
+    }
+    slots_.resize(capacity);
+}
+
+void HashRelevanceAccumulator::Add(size_t document_ordinal, double relevance) {
+    Slot* slot = &slots_[FindSlot(document_ordinal)];
+    if (slot->document_ordinal == EMPTY_SLOT) {
+        if (2 * (size_ + 1) > slots_.size()) {
+            Grow();
+            slot = &slots_[FindSlot(document_ordinal)];
+        }
+        slot->document_ordinal = document_ordinal;
+        ++size_;
+    }
+    slot->relevance += relevance;
+}
+
+size_t HashRelevanceAccumulator::FindSlot(size_t document_ordinal) const {
+    // Fibonacci hashing spreads consecutive ordinals over the table
+    const size_t mask = slots_.size() - 1;
+    size_t index = static_cast<size_t>((document_ordinal * 0x9E3779B97F4A7C15ull) >> 17) & mask;
+    while (slots_[index].document_ordinal != EMPTY_SLOT && slots_[index].document_ordinal != document_ordinal) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void HashRelevanceAccumulator::Grow() {
+    pmr::vector<Slot> old_slots(slots_.size() * 2, slots_.get_allocator());
+    swap(old_slots, slots_);
+    for (const Slot& slot : old_slots) {
+        if (slot.document_ordinal != EMPTY_SLOT) {
+            slots_[FindSlot(slot.document_ordinal)] = slot;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// Set of document ordinals stored as a bitmap
+class DocumentBitmap {
+public:
+    DocumentBitmap(size_t document_count, std::pmr::memory_resource* resource);
+
+    void Set(size_t document_ordinal);
+
+    bool Test(size_t document_ordinal) const;
+
+private:
+    std::pmr::vector<uint64_t> words_;
+};
+
+// Relevance of every document kept in an array indexed by ordinal. Suits queries
+// matching a sizable part of the collection. Concurrent Add calls are safe as long
+// as they add to different documents
+class DenseRelevanceAccumulator {
+public:
+    DenseRelevanceAccumulator(size_t document_count, std::pmr::memory_resource* resource);
+
+    void Add(size_t document_ordinal, double relevance);
+
+    // Calls action(document_ordinal, relevance) for the documents added to, by increasing ordinal
+    template <typename Action>
+    void ForEach(Action action) const;
+
+private:
+    std::pmr::vector<double> relevances_;
+    // Bytes rather than bits, so that threads adding to neighbouring documents do not race
+    std::pmr::vector<uint8_t> touched_;
+};
+
+// Relevance of candidate documents kept in an open addressing hash table with linear
+// probing. Suits narrow queries, the table is sized once from the expected candidate count
+class HashRelevanceAccumulator {
+public:
+    HashRelevanceAccumulator(size_t expected_count, std::pmr::memory_resource* resource);
+
+    void Add(size_t document_ordinal, double relevance);
+
+    // Calls action(document_ordinal, relevance) for the documents added to, by increasing ordinal
+    template <typename Action>
+    void ForEach(Action action) const;
+
+private:
+    static constexpr size_t EMPTY_SLOT = SIZE_MAX;
+
+    struct Slot {
+        size_t document_ordinal = EMPTY_SLOT;
+        double relevance = 0.0;
+    };
+
+    std::pmr::vector<Slot> slots_;
+    size_t size_ = 0;
+
+    size_t FindSlot(size_t document_ordinal) const;
+
+    void Grow();
+};
+
+    template <typename Action>
+    void DenseRelevanceAccumulator::ForEach(Action action) const {
+        for (size_t document_ordinal = 0; document_ordinal < touched_.size(); ++document_ordinal) {
+            if (touched_[document_ordinal]) {
+                action(document_ordinal, relevances_[document_ordinal]);
+            }
+        }
+    }
+
+    template <typename Action>
+    void HashRelevanceAccumulator::ForEach(Action action) const {
+        std::pmr::vector<std::pair<size_t, double>> entries(slots_.get_allocator());
+        entries.reserve(size_);
+        for (const Slot& slot : slots_) {
+            if (slot.document_ordinal != EMPTY_SLOT) {
+                entries.push_back({ slot.document_ordinal, slot.relevance });
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        for (const auto& [document_ordinal, relevance] : entries) {
+            action(document_ordinal, relevance);
+        }
+    }
@@ -1,25 +1,209 @@
 #include "remove_duplicates.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 using namespace std;
 
-void RemoveDuplicates(SearchServer& search_server) {
-    set<int> documents_to_remove;
-    map<set<string>, int> words_to_document;
-    for (const int document_id : search_server) {
-        set<string> words_from_documents;
-        const map<string, double> word_freqs = search_server.GetWordFrequencies(document_id);
-        for (auto [word, freqs] : word_freqs) {
-            words_from_documents.insert(word);
+namespace {
+
+const size_t MIN_HASH_COUNT = 128;
+
+uint64_t MixHash(uint64_t value) {
+    // splitmix64 finalizer
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// Sums of two independent hashes of the term ids do not depend on word order
+struct Fingerprint {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator<(const Fingerprint& other) const {
+        return pair(low, high) < pair(other.low, other.high);
+    }
+
+    bool operator==(const Fingerprint& other) const {
+        return low == other.low && high == other.high;
+    }
+};
+
+Fingerprint ComputeFingerprint(const vector<size_t>& term_ids) {
+    Fingerprint fingerprint;
+    for (const size_t term_id : term_ids) {
+        fingerprint.low += MixHash(term_id);
+        fingerprint.high += MixHash(term_id ^ 0xA5A5A5A5A5A5A5A5ULL);
+    }
+    return fingerprint;
+}
+
+using MinHashSignature = array<uint64_t, MIN_HASH_COUNT>;
+
+MinHashSignature ComputeMinHashSignature(const vector<size_t>& term_ids) {
+    MinHashSignature signature;
+    signature.fill(numeric_limits<uint64_t>::max());
+    for (const size_t term_id : term_ids) {
+        for (size_t i = 0; i < MIN_HASH_COUNT; ++i) {
+            signature[i] = min(signature[i], MixHash(term_id * MIN_HASH_COUNT + i));
+        }
+    }
+    return signature;
+}
+
+// Both id lists are sorted
+double ComputeJaccardSimilarity(const vector<size_t>& lhs, const vector<size_t>& rhs) {
+    if (lhs.empty() && rhs.empty()) {
+        return 1.0;
+    }
+    size_t common = 0;
+    for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end() && rhs_it != rhs.end();) {
+        if (*lhs_it < *rhs_it) {
+            ++lhs_it;
         }
-        if (words_to_document.count(words_from_documents)) {
-            documents_to_remove.insert(document_id);
+        else if (*rhs_it < *lhs_it) {
+            ++rhs_it;
         }
         else {
-            words_to_document[words_from_documents] = document_id;
+            ++common;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return common * 1.0 / (lhs.size() + rhs.size() - common);
+}
+
+// Fewest LSH bands whose banding threshold (1 / bands)^(1 / rows) is not above the
+// similarity threshold. Pairs at the threshold then become candidates with high probability
+size_t ChooseBandCount(double jaccard_threshold) {
+    size_t band_count = 1;
+    while (band_count < MIN_HASH_COUNT) {
+        const double rows = static_cast<double>(MIN_HASH_COUNT / band_count);
+        if (pow(1.0 / band_count, 1.0 / rows) <= jaccard_threshold) {
+            break;
         }
+        band_count *= 2;
     }
-    for (int document_id : documents_to_remove) {
+    return band_count;
+}
+
+vector<int> GetDocumentIds(const SearchServer& search_server) {
+    return vector<int>(search_server.begin(), search_server.end());
+}
+
+void RemoveFound(SearchServer& search_server, const vector<int>& documents_to_remove) {
+    for (const int document_id : documents_to_remove) {
         cout << "Found duplicate document id " << document_id << endl;
         search_server.RemoveDocument(document_id);
     }
-}
\ No newline at end of file
+}
+
+}  // namespace
+
+void RemoveDuplicates(SearchServer& search_server) {
+    const vector<int> document_ids = GetDocumentIds(search_server);
+    vector<vector<size_t>> word_sets(document_ids.size());
+    transform(execution::par, document_ids.begin(), document_ids.end(), word_sets.begin(),
+        [&search_server](int document_id) {
+            return search_server.GetTermIds(document_id);
+        });
+    // Documents are referred to by index, which follows the id order
+    vector<pair<Fingerprint, size_t>> fingerprints(document_ids.size());
+    vector<size_t> indexes(document_ids.size());
+    iota(indexes.begin(), indexes.end(), 0);
+    transform(execution::par, indexes.begin(), indexes.end(), fingerprints.begin(),
+        [&word_sets](size_t i) {
+            return pair(ComputeFingerprint(word_sets[i]), i);
+        });
+    sort(execution::par, fingerprints.begin(), fingerprints.end());
+
+    // Equal fingerprints are only candidates, word sets are compared exactly inside a group
+    vector<int> documents_to_remove;
+    for (auto group_begin = fingerprints.begin(); group_begin != fingerprints.end();) {
+        const auto group_end = find_if(group_begin, fingerprints.end(),
+            [&group_begin](const pair<Fingerprint, size_t>& fingerprint) {
+                return !(fingerprint.first == group_begin->first);
+            });
+        if (group_end - group_begin > 1) {
+            vector<const vector<size_t>*> kept_word_sets;
+            for (auto it = group_begin; it != group_end; ++it) {
+                const vector<size_t>& word_set = word_sets[it->second];
+                if (any_of(kept_word_sets.begin(), kept_word_sets.end(),
+                    [&word_set](const vector<size_t>* kept_word_set) {
+                        return *kept_word_set == word_set;
+                    })) {
+                    documents_to_remove.push_back(document_ids[it->second]);
+                }
+                else {
+                    kept_word_sets.push_back(&word_set);
+                }
+            }
+        }
+        group_begin = group_end;
+    }
+    sort(documents_to_remove.begin(), documents_to_remove.end());
+    RemoveFound(search_server, documents_to_remove);
+}
+
+void RemoveNearDuplicates(SearchServer& search_server, double jaccard_threshold) {
+    if (jaccard_threshold <= 0.0 || jaccard_threshold > 1.0) {
+        throw invalid_argument("порог сходства должен быть в интервале (0, 1]"s);
+    }
+    const vector<int> document_ids = GetDocumentIds(search_server);
+    vector<vector<size_t>> word_sets(document_ids.size());
+    transform(execution::par, document_ids.begin(), document_ids.end(), word_sets.begin(),
+        [&search_server](int document_id) {
+            return search_server.GetTermIds(document_id);
+        });
+    vector<MinHashSignature> signatures(document_ids.size());
+    transform(execution::par, word_sets.begin(), word_sets.end(), signatures.begin(), ComputeMinHashSignature);
+
+    const size_t band_count = ChooseBandCount(jaccard_threshold);
+    const size_t rows = MIN_HASH_COUNT / band_count;
+    // Bucket of a band is a hash of its rows; buckets list kept documents by index
+    vector<unordered_map<uint64_t, vector<size_t>>> band_buckets(band_count);
+    vector<uint64_t> band_hashes(band_count);
+    vector<int> documents_to_remove;
+    for (size_t document = 0; document < document_ids.size(); ++document) {
+        for (size_t band = 0; band < band_count; ++band) {
+            uint64_t band_hash = band;
+            for (size_t row = band * rows; row < (band + 1) * rows; ++row) {
+                band_hash = MixHash(band_hash ^ signatures[document][row]);
+            }
+            band_hashes[band] = band_hash;
+        }
+
+        bool is_duplicate = false;
+        for (size_t band = 0; band < band_count && !is_duplicate; ++band) {
+            const auto bucket = band_buckets[band].find(band_hashes[band]);
+            if (bucket == band_buckets[band].end()) {
+                continue;
+            }
+            is_duplicate = any_of(bucket->second.begin(), bucket->second.end(),
+                [&](size_t kept_document) {
+                    return ComputeJaccardSimilarity(word_sets[document], word_sets[kept_document]) >= jaccard_threshold;
+                });
+        }
+
+        if (is_duplicate) {
+            documents_to_remove.push_back(document_ids[document]);
+        }
+        else {
+            for (size_t band = 0; band < band_count; ++band) {
+                band_buckets[band][band_hashes[band]].push_back(document);
+            }
+        }
+    }
+    RemoveFound(search_server, documents_to_remove);
+}
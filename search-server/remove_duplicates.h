@@ -4,5 +4,10 @@
 #include <iostream>
 #include "search_server.h"
 
+// Removes every document whose set of words equals the set of a document with a smaller id
+void RemoveDuplicates(SearchServer& search_server);
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+// Removes every document whose word set has Jaccard similarity of at least jaccard_threshold
+// with a kept document of smaller id. Candidates are found with MinHash LSH, so a pair
+// close to the threshold may be missed; found candidates are verified exactly
+void RemoveNearDuplicates(SearchServer& search_server, double jaccard_threshold);
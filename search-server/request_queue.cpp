@@ -1,40 +1,119 @@
 #include "request_queue.h"
 
+#include <algorithm>
+
 using namespace std;
 
+namespace {
+
+uint32_t GetBucketTime(uint64_t state) {
+    return static_cast<uint32_t>(state >> 32);
+}
+
+uint32_t GetBucketCount(uint64_t state) {
+    return static_cast<uint32_t>(state);
+}
+
+uint64_t MakeBucketState(uint32_t time, uint32_t count) {
+    return static_cast<uint64_t>(time) << 32 | count;
+}
+
+}  // namespace
+
 RequestQueue::RequestQueue(const SearchServer& search_server)
+    : RequestQueue(search_server, chrono::steady_clock::duration::zero())
+{
+}
+
+RequestQueue::RequestQueue(const SearchServer& search_server, chrono::steady_clock::duration bucket_width)
     : search_server_(search_server)
-    , no_results_requests_(0)
-    , current_time_(0)
-    {
+    , bucket_width_(bucket_width)
+    , start_time_(chrono::steady_clock::now())
+{
+    if (bucket_width < chrono::steady_clock::duration::zero()) {
+        throw invalid_argument("отрицательная ширина интервала"s);
+    }
 }
 
-vector<Document> RequestQueue::AddFindRequest(const string& raw_query, DocumentStatus status) {
-    return AddFindRequest(
-        raw_query,
-        [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentStatus status) {
+    return AddFindRequest(raw_query, DocumentStatusPredicate{ status });
 }
 
-vector<Document> RequestQueue::AddFindRequest(const string& raw_query) {
+vector<Document> RequestQueue::AddFindRequest(string_view raw_query) {
     return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return no_results_requests_;
+    if (bucket_width_ != chrono::steady_clock::duration::zero()) {
+        Expire(GetWallClockTime());
+    }
+    return static_cast<int>(max<int64_t>(0, no_results_requests_.load(memory_order_relaxed)));
+}
+
+void RequestQueue::AddRequest(size_t results_num) {
+    const uint32_t time = bucket_width_ == chrono::steady_clock::duration::zero()
+        ? current_time_.fetch_add(1, memory_order_relaxed) + 1
+        : GetWallClockTime();
+    Expire(time);
+    if (results_num != 0) {
+        return;
+    }
+
+    atomic<uint64_t>& bucket = buckets_[time % min_in_day_];
+    uint64_t state = bucket.load(memory_order_relaxed);
+    while (true) {
+        const uint32_t bucket_time = GetBucketTime(state);
+        // The bucket already serves a later time, so this request has left the window
+        if (IsBefore(time, bucket_time)) {
+            return;
+        }
+        // An earlier time in the bucket is out of the window, its count goes with it
+        const bool is_same_time = bucket_time == time;
+        const uint32_t count = is_same_time ? GetBucketCount(state) + 1 : 1;
+        // Sequentially consistent like the expired time claim in Expire and the reads after both.
+        // Then either this call sees the bucket expired or the expiring call sees the new count
+        if (bucket.compare_exchange_weak(state, MakeBucketState(time, count), memory_order_seq_cst, memory_order_relaxed)) {
+            no_results_requests_.fetch_add(is_same_time ? 1 : 1 - static_cast<int64_t>(GetBucketCount(state)), memory_order_relaxed);
+            break;
+        }
+    }
+    // A slow request may land after its time was expired
+    const uint32_t expired_time = expired_time_.load(memory_order_seq_cst);
+    if (!IsBefore(expired_time, time)) {
+        ClearBucket(time, expired_time);
+    }
 }
 
-void RequestQueue::AddRequest(int results_num) {
-    ++current_time_;
-    while (!requests_.empty() && min_in_day_ <= current_time_ - requests_.front().timestamp) {
-        if (0 == requests_.front().results) {
-            --no_results_requests_;
+bool RequestQueue::IsBefore(uint32_t lhs, uint32_t rhs) {
+    return static_cast<int32_t>(lhs - rhs) < 0;
+}
+
+uint32_t RequestQueue::GetWallClockTime() const {
+    return static_cast<uint32_t>((chrono::steady_clock::now() - start_time_) / bucket_width_) + 1;
+}
+
+void RequestQueue::Expire(uint32_t time) const {
+    const uint32_t expired_time = time - min_in_day_;
+    uint32_t claimed_time = expired_time_.load(memory_order_relaxed);
+    while (IsBefore(claimed_time, expired_time)) {
+        // After a pause longer than the window every bucket is visited once, not once per time step
+        const uint32_t next_time = expired_time - claimed_time > static_cast<uint32_t>(min_in_day_)
+            ? expired_time - min_in_day_ + 1
+            : claimed_time + 1;
+        if (expired_time_.compare_exchange_weak(claimed_time, next_time, memory_order_seq_cst, memory_order_relaxed)) {
+            ClearBucket(next_time, expired_time);
+            claimed_time = next_time;
         }
-        requests_.pop_front();
     }
-    requests_.push_back({ current_time_, results_num });
-    if (0 == results_num) {
-        ++no_results_requests_;
+}
+
+void RequestQueue::ClearBucket(uint32_t bucket_time, uint32_t expired_time) const {
+    atomic<uint64_t>& bucket = buckets_[bucket_time % min_in_day_];
+    uint64_t state = bucket.load(memory_order_seq_cst);
+    while (GetBucketCount(state) != 0 && !IsBefore(expired_time, GetBucketTime(state))) {
+        if (bucket.compare_exchange_weak(state, MakeBucketState(GetBucketTime(state), 0), memory_order_relaxed)) {
+            no_results_requests_.fetch_sub(GetBucketCount(state), memory_order_relaxed);
+            break;
+        }
     }
 }
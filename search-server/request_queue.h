@@ -1,38 +1,62 @@
 #pragma once
-#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include "search_server.h"
 
 
+// Counts requests without results among the last min_in_day_ requests, or in wall-clock mode
+// among the requests of the last min_in_day_ time buckets. Every method may be called from
+// several threads without locks. Counts are exact whenever no call is in progress
 class RequestQueue {
 public:
     explicit RequestQueue(const SearchServer& search_server);
 
+    // Wall-clock mode, buckets of one minute make the window a day
+    RequestQueue(const SearchServer& search_server, std::chrono::steady_clock::duration bucket_width);
+
     template <typename DocumentPredicate>
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
 
-    std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentStatus status);
+    std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentStatus status);
 
-    std::vector<Document> AddFindRequest(const std::string& raw_query);
+    std::vector<Document> AddFindRequest(std::string_view raw_query);
 
+    // Constant time when counting requests, amortized constant in wall-clock mode
     int GetNoResultRequests() const;
 
 private:
-    struct QueryResult {
-        uint64_t timestamp;
-        int results;
-    };
+    const static int min_in_day_ = 1440;
 
-    std::deque<QueryResult> requests_;
     const SearchServer& search_server_;
-    int no_results_requests_;
-    uint64_t current_time_;
-    const static int min_in_day_ = 1440;
+    // Zero when every request is a time step of its own
+    const std::chrono::steady_clock::duration bucket_width_;
+    const std::chrono::steady_clock::time_point start_time_;
+    std::atomic<uint32_t> current_time_{ 0 };
+    // Times up to this one have left the window and their buckets are cleared or being cleared
+    mutable std::atomic<uint32_t> expired_time_{ 0 };
+    // Bucket of time t is t % min_in_day_. Its state keeps the time in the high half
+    // and the number of requests without results made then in the low half
+    mutable std::array<std::atomic<uint64_t>, min_in_day_> buckets_{};
+    // May go below zero for a moment while calls race
+    mutable std::atomic<int64_t> no_results_requests_{ 0 };
+
+    void AddRequest(size_t results_num);
+
+    // Times wrap around, they are compared by their difference
+    static bool IsBefore(uint32_t lhs, uint32_t rhs);
+
+    uint32_t GetWallClockTime() const;
+
+    // Clears the buckets of the times which left the window by the given time
+    void Expire(uint32_t time) const;
 
-    void AddRequest(int results_num);
+    void ClearBucket(uint32_t bucket_time, uint32_t expired_time) const;
 };
 
     template <typename DocumentPredicate>
-    std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
+    std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
         const auto result = search_server_.FindTopDocuments(raw_query, document_predicate);
         AddRequest(result.size());
         return result;
@@ -0,0 +1,123 @@
+#include "search_metrics.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+#include <string_view>
+
+using namespace std;
+
+namespace {
+
+const array<string_view, SEARCH_STAGE_COUNT> STAGE_NAMES = {
+    "find_top_documents_ns"sv,
+    "parse_ns"sv,
+    "postings_scan_ns"sv,
+    "scoring_ns"sv,
+    "top_k_ns"sv,
+    "match_ns"sv,
+};
+
+// Number of significant bits, the last bucket also takes the largest values
+size_t GetBucket(uint64_t value) {
+    size_t bucket = 0;
+    for (; value != 0; value >>= 1) {
+        ++bucket;
+    }
+    return min(bucket, Histogram::BUCKET_COUNT - 1);
+}
+
+void ExportHistogram(ostream& output, string_view name, const Histogram& histogram) {
+    output << name
+        << " count="s << histogram.GetCount()
+        << " sum="s << histogram.GetSum()
+        << " p50="s << histogram.GetQuantile(0.5)
+        << " p90="s << histogram.GetQuantile(0.9)
+        << " p99="s << histogram.GetQuantile(0.99)
+        << " max="s << histogram.GetQuantile(1.0) << '\n';
+}
+
+}  // namespace
+
+void Histogram::Record(uint64_t value) {
+    buckets_[GetBucket(value)].fetch_add(1, memory_order_relaxed);
+    count_.fetch_add(1, memory_order_relaxed);
+    sum_.fetch_add(value, memory_order_relaxed);
+}
+
+uint64_t Histogram::GetCount() const {
+    return count_.load(memory_order_relaxed);
+}
+
+uint64_t Histogram::GetSum() const {
+    return sum_.load(memory_order_relaxed);
+}
+
+uint64_t Histogram::GetQuantile(double quantile) const {
+    const uint64_t count = GetCount();
+    if (count == 0) {
+        return 0;
+    }
+    // Rank of the value, counted from one
+    const uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(quantile * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets_[bucket].load(memory_order_relaxed);
+        if (seen >= rank) {
+            return bucket == 0 ? 0 : (uint64_t{ 1 } << bucket) - 1;
+        }
+    }
+    return numeric_limits<uint64_t>::max();
+}
+
+void Histogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    count_.store(0, memory_order_relaxed);
+    sum_.store(0, memory_order_relaxed);
+}
+
+void SearchMetrics::RecordStage(SearchStage stage, chrono::nanoseconds duration) {
+    stage_latencies_[static_cast<size_t>(stage)].Record(duration.count());
+}
+
+void SearchMetrics::RecordPostingsTouched(uint64_t posting_count) {
+    postings_touched_.Record(posting_count);
+}
+
+const Histogram& SearchMetrics::GetStageLatencies(SearchStage stage) const {
+    return stage_latencies_[static_cast<size_t>(stage)];
+}
+
+const Histogram& SearchMetrics::GetPostingsTouched() const {
+    return postings_touched_;
+}
+
+void SearchMetrics::Reset() {
+    for (Histogram& histogram : stage_latencies_) {
+        histogram.Reset();
+    }
+    postings_touched_.Reset();
+}
+
+void SearchMetrics::Export(ostream& output) const {
+    for (size_t stage = 0; stage < SEARCH_STAGE_COUNT; ++stage) {
+        ExportHistogram(output, STAGE_NAMES[stage], stage_latencies_[stage]);
+    }
+    ExportHistogram(output, "postings_touched"sv, postings_touched_);
+}
+
+SearchMetrics& GetSearchMetrics() {
+    static SearchMetrics metrics;
+    return metrics;
+}
+
+StageTimer::StageTimer(SearchStage stage)
+    : stage_(stage)
+    , start_time_(LogDuration::Clock::now()) {
+}
+
+StageTimer::~StageTimer() {
+    GetSearchMetrics().RecordStage(stage_, LogDuration::Clock::now() - start_time_);
+}
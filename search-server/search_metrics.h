@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "log_duration.h"
+
+// Hot path hooks of the server record into the registry only when built with
+// SEARCH_SERVER_METRICS defined, otherwise they expand to nothing
+#ifdef SEARCH_SERVER_METRICS
+#define SEARCH_METRICS_STAGE(stage) StageTimer UNIQUE_VAR_NAME_PROFILE(stage)
+#define SEARCH_METRICS_POSTINGS(count) GetSearchMetrics().RecordPostingsTouched(count)
+#else
+#define SEARCH_METRICS_STAGE(stage)
+#define SEARCH_METRICS_POSTINGS(count)
+#endif
+
+enum class SearchStage {
+    // A whole FindTopDocuments call
+    FIND_TOP_DOCUMENTS,
+    // Parsing the query into plus and minus words
+    PARSE,
+    // Walking the postings of the plus words, including the scores in document at a time retrieval
+    POSTINGS_SCAN,
+    // Turning the accumulated relevances into documents
+    SCORING,
+    TOP_K,
+    // A whole MatchDocument call
+    MATCH,
+};
+
+const size_t SEARCH_STAGE_COUNT = 6;
+
+// Counts of values in power of two buckets: bucket i holds values below 2^i not counted by bucket i - 1.
+// Updates are relaxed atomic increments, so any thread may record
+class Histogram {
+public:
+    static constexpr size_t BUCKET_COUNT = 64;
+
+    void Record(uint64_t value);
+
+    uint64_t GetCount() const;
+
+    uint64_t GetSum() const;
+
+    // Upper bound of the bucket the given share of the values falls into
+    uint64_t GetQuantile(double quantile) const;
+
+    void Reset();
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<uint64_t> sum_{ 0 };
+};
+
+// Latencies of the search stages in nanoseconds and postings touched per query
+class SearchMetrics {
+public:
+    void RecordStage(SearchStage stage, std::chrono::nanoseconds duration);
+
+    void RecordPostingsTouched(uint64_t posting_count);
+
+    const Histogram& GetStageLatencies(SearchStage stage) const;
+
+    const Histogram& GetPostingsTouched() const;
+
+    void Reset();
+
+    // One line per metric: name, count, sum, p50, p90, p99 and max bucket bounds
+    void Export(std::ostream& output) const;
+
+private:
+    std::array<Histogram, SEARCH_STAGE_COUNT> stage_latencies_;
+    Histogram postings_touched_;
+};
+
+// Registry shared by every server of the process
+SearchMetrics& GetSearchMetrics();
+
+// Records the time spent in its scope as a stage latency
+class StageTimer {
+public:
+    explicit StageTimer(SearchStage stage);
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    ~StageTimer();
+
+private:
+    SearchStage stage_;
+    LogDuration::Clock::time_point start_time_;
+};
@@ -1,136 +1,374 @@
 #include "search_server.h"
 
+#include <thread>
+#include <unordered_map>
+
 using namespace std;
 
 SearchServer::SearchServer(const string& stop_words_text)
+    : SearchServer(string_view(stop_words_text))
+{
+}
+
+SearchServer::SearchServer(string_view stop_words_text)
     : SearchServer(SplitIntoWords(stop_words_text))
 {
 }
 
-void SearchServer::AddDocument(int document_id, const string& document, DocumentStatus status, const vector<int>& ratings) {
+SearchServer::SearchServer(const SearchServer& other)
+    : stop_words_(other.stop_words_)
+    , term_ids_(other.term_ids_, index_resource_.get())
+    , postings_(other.postings_)
+    , term_stats_(other.term_stats_)
+    , free_term_ids_(other.free_term_ids_)
+    , documents_(other.documents_)
+    , document_ratings_(other.document_ratings_)
+    , document_statuses_(other.document_statuses_)
+    , document_ordinals_(other.document_ordinals_, index_resource_.get())
+    , document_ids_(other.document_ids_, index_resource_.get())
+    , forward_entries_(other.forward_entries_)
+    , forward_spans_(other.forward_spans_)
+    , removed_forward_entry_count_(other.removed_forward_entry_count_)
+    , term_words_(other.term_words_.size())
+    , retrieval_mode_(other.retrieval_mode_)
+    , generation_(other.generation_)
+{
+    for (const auto& [word, term_id] : term_ids_) {
+        term_words_[term_id] = word;
+    }
+}
+
+void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
     if (document_id < 0) {
         throw invalid_argument("документ с отрицательным id"s);
     }
-    if (documents_.count(document_id) > 0) {
+    if (document_ordinals_.count(document_id) > 0) {
         throw invalid_argument("документ c таким id уже существует"s);
     }
 
-    vector<string> words = SplitIntoWordsNoStop(document);
+    const vector<string_view> words = SplitIntoWordsNoStop(document);
     const double inv_word_count = 1.0 / words.size();
-    for (const string& word : words) {
-        word_to_document_freqs_[word][document_id] += inv_word_count;
-        doc_to_word_freq_[document_id][word] += inv_word_count;
+    const auto word_occurrences = CountWordOccurrences(words);
+
+    // New documents get the largest ordinal, so appending keeps postings lists sorted.
+    // The forward index refers to the dictionary by term ids, the document text is not kept
+    const size_t document_ordinal = documents_.size();
+    ForwardEntry* forward_entry = AppendForwardSpan(word_occurrences.size());
+    for (const auto& [word, occurrences] : word_occurrences) {
+        const size_t term_id = InternTerm(word).second;
+        const double term_freq = ComputeTermFreq(occurrences, inv_word_count);
+        *forward_entry++ = { static_cast<uint32_t>(term_id), occurrences };
+        term_stats_[term_id].max_term_freq = max(term_stats_[term_id].max_term_freq, term_freq);
+        postings_[term_id].Append(document_ordinal, occurrences);
     }
-    documents_.emplace(document_id, DocumentData{ ComputeAverageRating(ratings), status });
+    documents_.push_back({ document_id, inv_word_count });
+    document_ratings_.push_back(ComputeAverageRating(ratings));
+    document_statuses_.push_back(status);
+    document_ordinals_.emplace(document_id, document_ordinal);
     document_ids_.emplace(document_id);
+    ++generation_;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(
-        raw_query,
-        [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
+vector<AddDocumentError> SearchServer::AddDocuments(const vector<NewDocument>& documents) {
+    struct TokenizedDocument {
+        vector<pair<string_view, uint32_t>> word_occurrences;
+        double inv_word_count = 0.0;
+        string error;
+    };
+    vector<TokenizedDocument> tokenized(documents.size());
+    transform(execution::par, documents.begin(), documents.end(), tokenized.begin(),
+        [this](const NewDocument& document) {
+            TokenizedDocument result;
+            try {
+                const vector<string_view> words = SplitIntoWordsNoStop(document.text);
+                result.inv_word_count = 1.0 / words.size();
+                result.word_occurrences = CountWordOccurrences(words);
+            }
+            catch (const invalid_argument& e) {
+                result.error = e.what();
+            }
+            return result;
+        });
+
+    // Ids are checked in batch order, so a repeated id is rejected like a second AddDocument
+    vector<AddDocumentError> errors;
+    vector<size_t> accepted;
+    // Next forward index entry of every accepted document
+    vector<ForwardEntry*> forward_entries;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const NewDocument& document = documents[i];
+        string error;
+        if (document.id < 0) {
+            error = "документ с отрицательным id"s;
+        }
+        else if (document_ordinals_.count(document.id) > 0) {
+            error = "документ c таким id уже существует"s;
+        }
+        else {
+            error = move(tokenized[i].error);
+        }
+        if (!error.empty()) {
+            errors.push_back({ document.id, move(error) });
+            continue;
+        }
+        document_ordinals_.emplace(document.id, documents_.size());
+        document_ids_.emplace(document.id);
+        documents_.push_back({ document.id, tokenized[i].inv_word_count });
+        document_ratings_.push_back(ComputeAverageRating(document.ratings));
+        document_statuses_.push_back(document.status);
+        accepted.push_back(i);
+    }
+    if (accepted.empty()) {
+        return errors;
+    }
+    // Spans are reserved together, the arena does not move while they are filled
+    size_t forward_entry_count = 0;
+    for (const size_t i : accepted) {
+        forward_entry_count += tokenized[i].word_occurrences.size();
+    }
+    forward_entries_.reserve(forward_entries_.size() + forward_entry_count);
+    for (const size_t i : accepted) {
+        forward_entries.push_back(AppendForwardSpan(tokenized[i].word_occurrences.size()));
+    }
+    ++generation_;
+
+    // Documents are split into contiguous chunks, one per worker. A worker looks the words of
+    // its chunk up in the dictionary once each, new words are interned in between
+    const size_t first_ordinal = documents_.size() - accepted.size();
+    const size_t chunk_count = min<size_t>(max(1u, thread::hardware_concurrency()), accepted.size());
+    const auto chunk_begin = [&](size_t chunk) {
+        return chunk * accepted.size() / chunk_count;
+    };
+    vector<size_t> chunk_indexes(chunk_count);
+    iota(chunk_indexes.begin(), chunk_indexes.end(), 0);
+    vector<unordered_map<string_view, uint32_t>> chunk_term_ids(chunk_count);
+    // Term id of every word of the chunk's documents in order, the map keeps its values in place
+    vector<vector<const uint32_t*>> chunk_word_term_ids(chunk_count);
+    vector<vector<string_view>> chunk_new_words(chunk_count);
+    const uint32_t new_term_id = numeric_limits<uint32_t>::max();
+    for_each(execution::par, chunk_indexes.begin(), chunk_indexes.end(),
+        [&](size_t chunk) {
+            for (size_t j = chunk_begin(chunk); j < chunk_begin(chunk + 1); ++j) {
+                for (const auto& [word, occurrences] : tokenized[accepted[j]].word_occurrences) {
+                    const auto [it, is_inserted] = chunk_term_ids[chunk].emplace(word, new_term_id);
+                    chunk_word_term_ids[chunk].push_back(&it->second);
+                    if (!is_inserted) {
+                        continue;
+                    }
+                    if (const auto term = term_ids_.find(word); term != term_ids_.end()) {
+                        it->second = static_cast<uint32_t>(term->second);
+                    }
+                    else {
+                        chunk_new_words[chunk].push_back(word);
+                    }
+                }
+            }
+        });
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        for (const string_view word : chunk_new_words[chunk]) {
+            chunk_term_ids[chunk][word] = static_cast<uint32_t>(InternTerm(word).second);
+        }
+    }
+
+    // Every chunk fills the forward index of its documents and sorts its postings by term id.
+    // Chunks hold increasing ordinals, so appending them in chunk order keeps postings lists sorted
+    vector<vector<BatchPosting>> chunk_postings(chunk_count);
+    for_each(execution::par, chunk_indexes.begin(), chunk_indexes.end(),
+        [&](size_t chunk) {
+            vector<BatchPosting>& postings = chunk_postings[chunk];
+            postings.reserve(chunk_word_term_ids[chunk].size());
+            const uint32_t* const* word_term_id = chunk_word_term_ids[chunk].data();
+            for (size_t j = chunk_begin(chunk); j < chunk_begin(chunk + 1); ++j) {
+                ForwardEntry* forward_entry = forward_entries[j];
+                for (const auto& [word, occurrences] : tokenized[accepted[j]].word_occurrences) {
+                    const uint32_t term_id = **word_term_id++;
+                    *forward_entry++ = { term_id, occurrences };
+                    postings.push_back({ term_id, occurrences, first_ordinal + j });
+                }
+            }
+            sort(postings.begin(), postings.end());
+        });
+
+    // Terms are split into ranges, every worker merges the postings of its range from all chunks
+    const size_t term_count = postings_.size();
+    for_each(execution::par, chunk_indexes.begin(), chunk_indexes.end(),
+        [&](size_t range) {
+            const BatchPosting range_begin{ static_cast<uint32_t>(range * term_count / chunk_count), 0, 0 };
+            const BatchPosting range_end{ static_cast<uint32_t>((range + 1) * term_count / chunk_count), 0, 0 };
+            for (const vector<BatchPosting>& postings : chunk_postings) {
+                const auto first = lower_bound(postings.begin(), postings.end(), range_begin);
+                const auto last = lower_bound(first, postings.end(), range_end);
+                for (auto it = first; it != last; ++it) {
+                    const double term_freq = ComputeTermFreq(it->occurrences, documents_[it->document_ordinal].inv_word_count);
+                    TermStats& term_stats = term_stats_[it->term_id];
+                    term_stats.max_term_freq = max(term_stats.max_term_freq, term_freq);
+                    postings_[it->term_id].Append(it->document_ordinal, it->occurrences);
+                }
+            }
         });
+    return errors;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(raw_query, DocumentStatusPredicate{ status });
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query) const {
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
 size_t SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_ordinals_.size();
+}
+
+uint64_t SearchServer::GetGeneration() const {
+    return generation_;
 }
 
-std::set<int>::const_iterator SearchServer::begin() const {
+void SearchServer::SetRetrievalMode(RetrievalMode retrieval_mode) {
+    retrieval_mode_ = retrieval_mode;
+}
+
+pmr::set<int>::const_iterator SearchServer::begin() const {
     return document_ids_.begin();
 }
 
-std::set<int>::const_iterator SearchServer::end() const {
+pmr::set<int>::const_iterator SearchServer::end() const {
     return document_ids_.end();
 }
 
-const map<string, double>& SearchServer::GetWordFrequencies(int document_id) {
+SearchServer::WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = document_ordinals_.find(document_id);
+    if (it == document_ordinals_.end()) {
+        return {};
+    }
+    const size_t document_ordinal = it->second;
+    return WordFrequencies(GetForwardEntries(document_ordinal), forward_spans_[document_ordinal].size,
+        term_words_.data(), documents_[document_ordinal].inv_word_count);
+}
 
-    static const map<string, double> s_empty;
-    if (!doc_to_word_freq_.count(document_id)) {
-        return s_empty;
+vector<size_t> SearchServer::GetTermIds(int document_id) const {
+    const auto it = document_ordinals_.find(document_id);
+    if (it == document_ordinals_.end()) {
+        return {};
+    }
+    const ForwardEntry* entries = GetForwardEntries(it->second);
+    vector<size_t> term_ids(forward_spans_[it->second].size);
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        term_ids[i] = entries[i].term_id;
     }
-    return doc_to_word_freq_.at(document_id);
+    sort(term_ids.begin(), term_ids.end());
+    return term_ids;
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_view raw_query, int document_id) const {
+    return MatchDocument(execution::seq, raw_query, document_id);
 }
 
-tuple<vector<string>, DocumentStatus> SearchServer::MatchDocument(const string& raw_query, int document_id) const {
-    const Query query = ParseQuery(raw_query);
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::sequenced_policy&, string_view raw_query, int document_id) const {
+    SEARCH_METRICS_STAGE(SearchStage::MATCH);
+    QueryArena arena;
+    const Query query = ParseQuery(raw_query, arena.GetResource());
+    const size_t document_ordinal = document_ordinals_.at(document_id);
+    const DocumentStatus status = document_statuses_[document_ordinal];
 
-    vector<string> matched_words;
-    for (const string& word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+    // Minus words are checked first, a single hit makes the plus words irrelevant
+    for (const string_view word : query.minus_words) {
+        if (!FindDocumentWord(document_ordinal, word).empty()) {
+            return { vector<string_view>{}, status };
         }
     }
-    for (const string& word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            break;
+    vector<string_view> matched_words;
+    for (const string_view word : query.plus_words) {
+        const string_view document_word = FindDocumentWord(document_ordinal, word);
+        if (!document_word.empty()) {
+            matched_words.push_back(document_word);
         }
     }
-    return tuple{ matched_words, documents_.at(document_id).status };
+    return { matched_words, status };
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const execution::parallel_policy&, string_view raw_query, int document_id) const {
+    SEARCH_METRICS_STAGE(SearchStage::MATCH);
+    // Duplicates are removed from the matched words only, which is usually the shorter list
+    QueryArena arena;
+    const Query query = ParseQuery(raw_query, arena.GetResource(), false);
+    const size_t document_ordinal = document_ordinals_.at(document_id);
+    const DocumentStatus status = document_statuses_[document_ordinal];
+    const auto find_document_word = [this, document_ordinal](string_view word) {
+        return FindDocumentWord(document_ordinal, word);
+    };
+
+    if (any_of(execution::par, query.minus_words.begin(), query.minus_words.end(),
+        [&find_document_word](string_view word) {
+            return !find_document_word(word).empty();
+        })) {
+        return { vector<string_view>{}, status };
+    }
+    pmr::vector<string_view> matched_words(query.plus_words.size(), arena.GetResource());
+    transform(execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
+        find_document_word);
+    matched_words.erase(remove(matched_words.begin(), matched_words.end(), string_view{}), matched_words.end());
+    SortUnique(matched_words);
+    return { vector<string_view>(matched_words.begin(), matched_words.end()), status };
 }
 
-    /*void SearchServer::RemoveDocument(int document_id){
-        if (!document_ids_.count(document_id)) {
-            return;
-        }
-        for (auto& [word, freq] : doc_to_word_freq_[document_id]) {
-            word_to_document_freqs_[word].erase(document_id);
-        }
-        document_ids_.erase(document_id);
-        documents_.erase(document_id);
-        doc_to_word_freq_.erase(document_id);
-    }*/
 void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocument(const execution::sequenced_policy&, int document_id) {
     if (!document_ids_.count(document_id)) {
         return;
     }
-    for (auto& [word, ids_freqs] : word_to_document_freqs_) {
-        ids_freqs.erase(document_id);
+    const size_t document_ordinal = document_ordinals_.at(document_id);
+    const ForwardEntry* entries = GetForwardEntries(document_ordinal);
+    for (size_t i = 0; i < forward_spans_[document_ordinal].size; ++i) {
+        postings_[entries[i].term_id].Erase(document_ordinal);
     }
-    document_ids_.erase(document_id);
-    documents_.erase(document_id);
-    doc_to_word_freq_.erase(document_id);
+    ForgetDocument(document_id);
+}
+
+void SearchServer::RemoveDocument(const execution::parallel_policy&, int document_id) {
+    if (!document_ids_.count(document_id)) {
+        return;
+    }
+    const size_t document_ordinal = document_ordinals_.at(document_id);
+    const ForwardEntry* entries = GetForwardEntries(document_ordinal);
+
+    // Every word owns a separate postings list, so the lists can be edited concurrently
+    for_each(execution::par, entries, entries + forward_spans_[document_ordinal].size,
+        [this, document_ordinal](const ForwardEntry& entry) {
+            postings_[entry.term_id].Erase(document_ordinal);
+        });
+    ForgetDocument(document_id);
 }
 
-bool SearchServer::IsStopWord(const string& word) const {
+bool SearchServer::IsStopWord(string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
-bool SearchServer::IsValidWord(const string& word) {
+bool SearchServer::IsValidWord(string_view word) {
     // A valid word must not contain special characters
-    if (word[0] == '-') {
-        if (word[1] == '-' || word.length() == 1) {
-            return false;
-        }
-    }
-    return none_of(word.begin(), word.end(), [](char c) {
+    return IsValidMinusPrefix(word) && none_of(word.begin(), word.end(), [](char c) {
         return c >= '\0' && c < ' ';
         });
 }
 
-vector<string> SearchServer::SplitIntoWordsNoStop(const string& text ) const {
-    vector<string> result;
-    for (const string& word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
+bool SearchServer::IsValidMinusPrefix(string_view word) {
+    return word[0] != '-' || (word.length() > 1 && word[1] != '-');
+}
+
+vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
+    vector<string_view> result;
+    ForEachCheckedWord(text, [this, &result](string_view word, bool has_control_characters) {
+        if (has_control_characters || !IsValidMinusPrefix(word)) {
             throw invalid_argument("недопустимые символы в тексте добавляемого документа"s);
         }
         if (!IsStopWord(word)) {
             result.push_back(word);
         }
-    }
+    });
     return result;
 }
 
@@ -142,12 +380,12 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(string text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text, bool has_control_characters) const {
     bool is_minus = false;
-    if (IsValidWord(text)) {
+    if (!has_control_characters && IsValidMinusPrefix(text)) {
         if (text[0] == '-') {
             is_minus = true;
-            text = text.substr(1);
+            text.remove_prefix(1);
         }
     }
     else {
@@ -156,22 +394,402 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string text) const {
     return { text, is_minus, IsStopWord(text) };
 }
 
-SearchServer::Query SearchServer::ParseQuery(const string& text) const {
-    Query query;
-    for (const string& word : SplitIntoWords(text)) {
-        const QueryWord query_word = ParseQueryWord(word);
+SearchServer::Query SearchServer::ParseQuery(string_view text, pmr::memory_resource* resource, bool remove_duplicates) const {
+    SEARCH_METRICS_STAGE(SearchStage::PARSE);
+    Query query{ pmr::vector<string_view>(resource), pmr::vector<string_view>(resource) };
+    ForEachCheckedWord(text, [this, &query](string_view word, bool has_control_characters) {
+        const QueryWord query_word = ParseQueryWord(word, has_control_characters);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
+                query.minus_words.push_back(query_word.data);
             }
             else {
-                query.plus_words.insert(query_word.data);
+                query.plus_words.push_back(query_word.data);
+            }
+        }
+    });
+    if (remove_duplicates) {
+        SortUnique(query.plus_words);
+        SortUnique(query.minus_words);
+    }
+    return query;
+}
+
+void SearchServer::SortUnique(pmr::vector<string_view>& words) {
+    sort(words.begin(), words.end());
+    words.erase(unique(words.begin(), words.end()), words.end());
+}
+
+const PostingsList* SearchServer::FindPostings(string_view word) const {
+    const auto it = term_ids_.find(word);
+    if (it == term_ids_.end()) {
+        return nullptr;
+    }
+    return &postings_[it->second];
+}
+
+bool SearchServer::BatchPosting::operator<(const BatchPosting& other) const {
+    return tie(term_id, document_ordinal) < tie(other.term_id, other.document_ordinal);
+}
+
+vector<pair<string_view, uint32_t>> SearchServer::CountWordOccurrences(const vector<string_view>& words) const {
+    vector<string_view> sorted_words = words;
+    sort(sorted_words.begin(), sorted_words.end());
+    vector<pair<string_view, uint32_t>> word_occurrences;
+    for (const string_view word : sorted_words) {
+        if (word_occurrences.empty() || word_occurrences.back().first != word) {
+            word_occurrences.push_back({ word, 0 });
+        }
+        ++word_occurrences.back().second;
+    }
+    return word_occurrences;
+}
+
+pmr::vector<double> SearchServer::ComputeInverseDocumentFreqs(const Query& query, pmr::memory_resource* resource) const {
+    pmr::vector<double> inverse_document_freqs(query.plus_words.size(), resource);
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const auto it = term_ids_.find(query.plus_words[i]);
+        if (it != term_ids_.end()) {
+            inverse_document_freqs[i] = ComputeWordInverseDocumentFreq(it->second);
+        }
+    }
+    return inverse_document_freqs;
+}
+
+SearchServer::MinusWordFilter::MinusWordFilter(size_t document_count, pmr::memory_resource* resource)
+    : document_count_(document_count)
+    , resource_(resource)
+    , probed_postings_(resource)
+{
+}
+
+void SearchServer::MinusWordFilter::Mask(const PostingsList& postings) {
+    if (!mask_) {
+        mask_.emplace(document_count_, resource_);
+    }
+    postings.ForEach([this](size_t document_ordinal, uint32_t) {
+        mask_->Set(document_ordinal);
+    });
+}
+
+void SearchServer::MinusWordFilter::Probe(const PostingsList& postings) {
+    probed_postings_.push_back(&postings);
+}
+
+bool SearchServer::MinusWordFilter::IsMasked(size_t document_ordinal) const {
+    return mask_ && mask_->Test(document_ordinal);
+}
+
+bool SearchServer::MinusWordFilter::IsProbed(size_t document_ordinal) const {
+    return any_of(probed_postings_.begin(), probed_postings_.end(), [document_ordinal](const PostingsList* postings) {
+        return postings->Contains(document_ordinal);
+    });
+}
+
+size_t SearchServer::CountPlusPostings(const Query& query) const {
+    size_t plus_posting_count = 0;
+    for (const string_view word : query.plus_words) {
+        if (const auto* postings = FindPostings(word)) {
+            plus_posting_count += postings->size();
+        }
+    }
+    return plus_posting_count;
+}
+
+bool SearchServer::IsPrunable(const Query& query, const pmr::vector<double>& inverse_document_freqs, size_t top_count) const {
+    if (retrieval_mode_ != RetrievalMode::PRUNED || top_count == 0) {
+        return false;
+    }
+    // Terms whose bounds together stay below the best single bound are likely to become
+    // non-essential, estimate how many postings they hold
+    QueryArena arena;
+    pmr::vector<pair<double, size_t>> terms(arena.GetResource());
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        const auto it = term_ids_.find(query.plus_words[i]);
+        if (it != term_ids_.end()) {
+            terms.push_back({ term_stats_[it->second].max_term_freq * inverse_document_freqs[i], postings_[it->second].size() });
+        }
+    }
+    if (terms.size() < 2) {
+        return false;
+    }
+    sort(terms.begin(), terms.end());
+    double max_score_sum = 0.0;
+    size_t skippable_posting_count = 0;
+    size_t posting_count = 0;
+    for (const auto& [max_score, term_posting_count] : terms) {
+        max_score_sum += max_score;
+        if (max_score_sum < terms.back().first) {
+            skippable_posting_count += term_posting_count;
+        }
+        posting_count += term_posting_count;
+    }
+    // The remaining terms have to fill the top by themselves, otherwise the threshold stays low
+    return posting_count >= PRUNING_MIN_POSTING_COUNT && skippable_posting_count * 3 >= posting_count * 2
+        && posting_count - skippable_posting_count >= top_count;
+}
+
+bool SearchServer::IsDenseQuery(size_t plus_posting_count) const {
+    return plus_posting_count * DENSE_ACCUMULATOR_RATIO >= documents_.size();
+}
+
+SearchServer::MinusWordFilter SearchServer::BuildMinusWordFilter(const Query& query, size_t plus_posting_count, pmr::memory_resource* resource) const {
+    MinusWordFilter minus_word_filter(documents_.size(), resource);
+    for (const string_view word : query.minus_words) {
+        const auto* postings = FindPostings(word);
+        if (postings == nullptr) {
+            continue;
+        }
+        // Probing a candidate decodes one block through the skip pointers
+        if (plus_posting_count < postings->GetBlocks().size()) {
+            minus_word_filter.Probe(*postings);
+        }
+        else {
+            minus_word_filter.Mask(*postings);
+        }
+    }
+    return minus_word_filter;
+}
+
+void SearchServer::SelectTopDocuments(vector<Document>& documents, size_t top_count) {
+    SEARCH_METRICS_STAGE(SearchStage::TOP_K);
+    const auto is_better = [](const Document& lhs, const Document& rhs) {
+        if (std::abs(lhs.relevance - rhs.relevance) < OBSERVATIONAL_ERROR) {
+            if (lhs.rating != rhs.rating) {
+                return lhs.rating > rhs.rating;
             }
+            return lhs.id < rhs.id;
+        }
+        return lhs.relevance > rhs.relevance;
+    };
+    // Heap-based partial sort costs O(n log k) instead of sorting every matched document
+    const size_t result_size = min(top_count, documents.size());
+    partial_sort(documents.begin(), documents.begin() + result_size, documents.end(), is_better);
+    documents.resize(result_size);
+    // Results are often stored, so the capacity left by an exhaustive scan is released.
+    // Pruned results come with little slack and are returned as they are
+    if (documents.capacity() > 4 * documents.size()) {
+        documents.shrink_to_fit();
+    }
+}
+
+const pair<const pmr::string, size_t>& SearchServer::InternTerm(string_view word) {
+    const auto it = term_ids_.find(word);
+    if (it != term_ids_.end()) {
+        return *it;
+    }
+    size_t term_id = postings_.size();
+    if (free_term_ids_.empty()) {
+        postings_.emplace_back();
+        term_stats_.emplace_back();
+    }
+    else {
+        term_id = free_term_ids_.back();
+        free_term_ids_.pop_back();
+    }
+    const auto& term = *term_ids_.emplace(word, term_id).first;
+    if (term_words_.size() <= term_id) {
+        term_words_.resize(term_id + 1);
+    }
+    term_words_[term_id] = term.first;
+    return term;
+}
+
+void SearchServer::ForgetDocument(int document_id) {
+    const size_t document_ordinal = document_ordinals_.at(document_id);
+    ForwardSpan& span = forward_spans_[document_ordinal];
+    const ForwardEntry* entries = GetForwardEntries(document_ordinal);
+    for (size_t i = 0; i < span.size; ++i) {
+        const uint32_t term_id = entries[i].term_id;
+        PostingsList& postings = postings_[term_id];
+        if (postings.empty()) {
+            // Release the storage too, an emptied list keeps its capacity otherwise
+            postings = PostingsList();
+            term_stats_[term_id] = TermStats();
+            free_term_ids_.push_back(term_id);
+            term_ids_.erase(term_ids_.find(term_words_[term_id]));
+            term_words_[term_id] = {};
         }
-        return query;
     }
+    removed_forward_entry_count_ += span.size;
+    span = ForwardSpan();
+    if (removed_forward_entry_count_ * 2 > forward_entries_.size()) {
+        CompactForwardIndex();
+    }
+    document_ids_.erase(document_id);
+    document_ordinals_.erase(document_id);
+    if ((documents_.size() - document_ordinals_.size()) * 2 > documents_.size()) {
+        CompactOrdinals();
+    }
+    ++generation_;
+}
+
+SearchServer::ForwardEntry* SearchServer::AppendForwardSpan(size_t size) {
+    forward_spans_.push_back({ forward_entries_.size(), static_cast<uint32_t>(size) });
+    forward_entries_.resize(forward_entries_.size() + size);
+    return forward_entries_.data() + forward_spans_.back().begin;
+}
+
+const SearchServer::ForwardEntry* SearchServer::GetForwardEntries(size_t document_ordinal) const {
+    return forward_entries_.data() + forward_spans_[document_ordinal].begin;
+}
+
+string_view SearchServer::FindDocumentWord(size_t document_ordinal, string_view word) const {
+    // Binary search over the document's words, no dictionary lookup is needed
+    const ForwardEntry* entries = GetForwardEntries(document_ordinal);
+    const ForwardEntry* entries_end = entries + forward_spans_[document_ordinal].size;
+    const auto it = lower_bound(entries, entries_end, word,
+        [this](const ForwardEntry& entry, string_view value) {
+            return term_words_[entry.term_id] < value;
+        });
+    if (it == entries_end || term_words_[it->term_id] != word) {
+        return {};
+    }
+    return term_words_[it->term_id];
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string& word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
-}
\ No newline at end of file
+void SearchServer::CompactForwardIndex() {
+    // Spans lie in ordinal order, so every one moves towards the front
+    size_t size = 0;
+    for (ForwardSpan& span : forward_spans_) {
+        if (span.begin != size) {
+            copy_n(forward_entries_.begin() + span.begin, span.size, forward_entries_.begin() + size);
+            span.begin = size;
+        }
+        size += span.size;
+    }
+    forward_entries_.resize(size);
+    forward_entries_.shrink_to_fit();
+    removed_forward_entry_count_ = 0;
+}
+
+void SearchServer::CompactOrdinals() {
+    vector<bool> is_live(documents_.size(), false);
+    for (const auto& [document_id, document_ordinal] : document_ordinals_) {
+        is_live[document_ordinal] = true;
+    }
+    // Live documents keep their order, so renumbered postings lists stay sorted
+    vector<size_t> new_ordinals(documents_.size());
+    size_t size = 0;
+    for (size_t document_ordinal = 0; document_ordinal < documents_.size(); ++document_ordinal) {
+        if (!is_live[document_ordinal]) {
+            continue;
+        }
+        new_ordinals[document_ordinal] = size;
+        documents_[size] = documents_[document_ordinal];
+        document_ratings_[size] = document_ratings_[document_ordinal];
+        document_statuses_[size] = document_statuses_[document_ordinal];
+        forward_spans_[size] = forward_spans_[document_ordinal];
+        ++size;
+    }
+    documents_.resize(size);
+    documents_.shrink_to_fit();
+    document_ratings_.resize(size);
+    document_ratings_.shrink_to_fit();
+    document_statuses_.resize(size);
+    document_statuses_.shrink_to_fit();
+    forward_spans_.resize(size);
+    forward_spans_.shrink_to_fit();
+    for (auto& [document_id, document_ordinal] : document_ordinals_) {
+        document_ordinal = new_ordinals[document_ordinal];
+    }
+    for_each(execution::par, postings_.begin(), postings_.end(),
+        [&new_ordinals](PostingsList& postings) {
+            PostingsList renumbered;
+            postings.ForEach([&](size_t document_ordinal, uint32_t occurrences) {
+                renumbered.Append(new_ordinals[document_ordinal], occurrences);
+            });
+            postings = move(renumbered);
+        });
+    CompactForwardIndex();
+}
+
+double SearchServer::ComputeTermFreq(uint32_t occurrences, double inv_word_count) {
+    double term_freq = 0.0;
+    for (uint32_t i = 0; i < occurrences; ++i) {
+        term_freq += inv_word_count;
+    }
+    return term_freq;
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(size_t term_id) const {
+    // Counts fit in 32 bits each, zero never matches since an indexed term has postings
+    const size_t posting_count = postings_[term_id].size();
+    const uint64_t idf_key = (static_cast<uint64_t>(GetDocumentCount()) << 32) | posting_count;
+    const TermStats& term_stats = term_stats_[term_id];
+    if (term_stats.idf_key.load(memory_order_acquire) == idf_key) {
+        return term_stats.inverse_document_freq.load(memory_order_relaxed);
+    }
+    const double inverse_document_freq = std::log(GetDocumentCount() * 1.0 / posting_count);
+    term_stats.inverse_document_freq.store(inverse_document_freq, memory_order_relaxed);
+    term_stats.idf_key.store(idf_key, memory_order_release);
+    return inverse_document_freq;
+}
+
+SearchServer::TermStats::TermStats(const TermStats& other)
+    : max_term_freq(other.max_term_freq)
+    , idf_key(other.idf_key.load(memory_order_acquire))
+    , inverse_document_freq(other.inverse_document_freq.load(memory_order_relaxed))
+{
+}
+
+SearchServer::TermStats& SearchServer::TermStats::operator=(const TermStats& other) {
+    max_term_freq = other.max_term_freq;
+    idf_key.store(other.idf_key.load(memory_order_acquire), memory_order_relaxed);
+    inverse_document_freq.store(other.inverse_document_freq.load(memory_order_relaxed), memory_order_relaxed);
+    return *this;
+}
+
+SearchServer::WordFrequencies::WordFrequencies(const ForwardEntry* entries, size_t size, const string_view* term_words, double inv_word_count)
+    : entries_(entries)
+    , size_(size)
+    , term_words_(term_words)
+    , inv_word_count_(inv_word_count)
+{
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::begin() const {
+    return Iterator(entries_, term_words_, inv_word_count_);
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::end() const {
+    return Iterator(entries_ + size_, term_words_, inv_word_count_);
+}
+
+size_t SearchServer::WordFrequencies::size() const {
+    return size_;
+}
+
+bool SearchServer::WordFrequencies::empty() const {
+    return size_ == 0;
+}
+
+SearchServer::WordFrequencies::Iterator::Iterator(const ForwardEntry* entry, const string_view* term_words, double inv_word_count)
+    : entry_(entry)
+    , term_words_(term_words)
+    , inv_word_count_(inv_word_count)
+{
+}
+
+SearchServer::WordFrequencies::Iterator::value_type SearchServer::WordFrequencies::Iterator::operator*() const {
+    return { term_words_[entry_->term_id], ComputeTermFreq(entry_->occurrences, inv_word_count_) };
+}
+
+SearchServer::WordFrequencies::Iterator& SearchServer::WordFrequencies::Iterator::operator++() {
+    ++entry_;
+    return *this;
+}
+
+SearchServer::WordFrequencies::Iterator SearchServer::WordFrequencies::Iterator::operator++(int) {
+    Iterator result = *this;
+    ++entry_;
+    return result;
+}
+
+bool SearchServer::WordFrequencies::Iterator::operator==(const Iterator& other) const {
+    return entry_ == other.entry_;
+}
+
+bool SearchServer::WordFrequencies::Iterator::operator!=(const Iterator& other) const {
+    return entry_ != other.entry_;
+}
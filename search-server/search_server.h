@@ -1,152 +1,718 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <set>
 #include <algorithm>
+#include <atomic>
 #include <numeric>
+#include <optional>
 #include <cmath>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <type_traits>
 
 #include "document.h"
+#include "postings_list.h"
+#include "query_arena.h"
+#include "relevance_accumulator.h"
+#include "search_metrics.h"
 #include "string_processing.h"
 
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double OBSERVATIONAL_ERROR = 1e-6;
 
+// Document of an AddDocuments batch. The text only has to live until the call returns
+struct NewDocument {
+    int id;
+    std::string_view text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+struct AddDocumentError {
+    int document_id;
+    std::string message;
+};
+
+// Predicates FindTopDocuments recognizes at compile time. They are evaluated on the status
+// and rating columns of the index a postings block at a time instead of per posting calls
+struct DocumentStatusPredicate {
+    DocumentStatus status;
+
+    bool operator()(int, DocumentStatus document_status, int) const {
+        return document_status == status;
+    }
+};
+
+// Accepts ratings from min_rating to max_rating inclusive
+struct DocumentRatingPredicate {
+    int min_rating;
+    int max_rating;
+
+    bool operator()(int, DocumentStatus, int rating) const {
+        return min_rating <= rating && rating <= max_rating;
+    }
+};
+
+// How sequential FindTopDocuments calls visit the postings of the plus words
+enum class RetrievalMode {
+    // Term at a time, every posting is scored
+    EXHAUSTIVE,
+    // Document at a time with MaxScore pruning of documents which cannot reach the top.
+    // Results are identical to EXHAUSTIVE
+    PRUNED,
+};
+
 class SearchServer {
+    // Shards of a ConcurrentSearchServer are scored with collection-wide statistics
+    friend class ConcurrentSearchServer;
+    // Cached results are keyed by the parsed query
+    friend class QueryCache;
+    // Index snapshots are written from and queried like the server internals
+    friend void SaveIndexSnapshot(const SearchServer& search_server, const std::string& path);
+    friend class MappedSearchServer;
+
 public:
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
 
     explicit SearchServer(const std::string& stop_words_text);
 
-    void AddDocument(int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings);
+    explicit SearchServer(std::string_view stop_words_text);
+
+    // Words of the forward index are views into the dictionary of its own server,
+    // so copying rebuilds them
+    SearchServer(const SearchServer& other);
+    SearchServer(SearchServer&& other) = default;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Adds the documents as consecutive AddDocument calls would, tokenizing them and building their postings in parallel.
+    // Rejected documents are skipped and reported with the message AddDocument throws
+    std::vector<AddDocumentError> AddDocuments(const std::vector<NewDocument>& documents);
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const ;
-    std::vector<Document> FindTopDocuments(const std::string& raw_query, DocumentStatus status) const ;
-    std::vector<Document> FindTopDocuments(const std::string& raw_query) const ;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const ;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const ;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const ;
+
+    // With a parallel policy document_predicate is called concurrently and must be thread-safe.
+    // top_count limits the result; pass (page + 1) * page_size to paginate deep results
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+        size_t top_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const ;
 
     size_t GetDocumentCount() const;
 
-    std::set<int>::const_iterator begin() const;
+    // Changes whenever documents are added or removed, results of equal queries
+    // found under equal generations are equal
+    uint64_t GetGeneration() const;
+
+    void SetRetrievalMode(RetrievalMode retrieval_mode);
 
-    std::set<int>::const_iterator end() const;
+    std::pmr::set<int>::const_iterator begin() const;
 
-    const std::map<std::string, double>& GetWordFrequencies(int document_id) ;
+    std::pmr::set<int>::const_iterator end() const;
 
-    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string& raw_query, int document_id) const;
+    class WordFrequencies;
 
+    // Empty for unknown documents. The view is valid until the next AddDocument or RemoveDocument
+    WordFrequencies GetWordFrequencies(int document_id) const;
+
+    // Sorted dictionary ids of the document's distinct words, empty for unknown documents.
+    // Ids identify words only until the next AddDocument or RemoveDocument
+    std::vector<size_t> GetTermIds(int document_id) const;
+
+    // Matched words are sorted views into the index, valid while the document is in the server
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&, std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, int document_id) const;
+
+    // Cost is proportional to the number of distinct words of the document
     void RemoveDocument(int document_id);
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id);
 
     //std::set<int> GetDuplicatedIds() const;
 
 
 private:
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
+        int id;
+        // Postings keep occurrence counts, term frequencies are restored with it
+        double inv_word_count;
+    };
+
+    // Statistics of a term kept next to its postings list
+    struct TermStats {
+        // Upper bound of the term frequency in a document. Exact until a posting is erased
+        double max_term_freq = 0.0;
+        // Inverse document frequency computed by the first query after the document or
+        // posting count changed. Queries may fill it concurrently, always with equal values
+        mutable std::atomic<uint64_t> idf_key{ 0 };
+        mutable std::atomic<double> inverse_document_freq{ 0.0 };
+
+        TermStats() = default;
+        TermStats(const TermStats& other);
+        TermStats& operator=(const TermStats& other);
     };
-    const std::set<std::string> stop_words_;
-    std::map<std::string, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
-    std::map<int, std::map<std::string, double>> doc_to_word_freq_;
+
+    // Nodes of the index maps come from a pool of the server, so removed documents
+    // leave their memory for new ones. Kept behind a pointer to survive moves
+    std::unique_ptr<std::pmr::unsynchronized_pool_resource> index_resource_
+        = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+
+    const std::set<std::string, std::less<>> stop_words_;
+    // Term dictionary: every indexed word gets a dense id addressing its postings list.
+    // Its keys are the only copies of words, the rest of the index refers to them by views
+    std::pmr::map<std::pmr::string, size_t, std::less<>> term_ids_{ index_resource_.get() };
+    std::vector<PostingsList> postings_;
+    std::vector<TermStats> term_stats_;
+    // Ids of terms whose postings lists became empty, reused by new terms
+    std::vector<size_t> free_term_ids_;
+    // Document metadata in insertion order. Ordinals of removed documents are not reused,
+    // once they make up half of the ordinals the live documents are renumbered.
+    // Ratings and statuses are separate columns, dense enough for filtering whole blocks
+    std::vector<DocumentData> documents_;
+    std::vector<int> document_ratings_;
+    std::vector<DocumentStatus> document_statuses_;
+    std::pmr::map<int, size_t> document_ordinals_{ index_resource_.get() };
+    std::pmr::set<int> document_ids_{ index_resource_.get() };
+    // Distinct word of a document, the term frequency is restored from the occurrences
+    struct ForwardEntry {
+        uint32_t term_id;
+        uint32_t occurrences;
+    };
+    struct ForwardSpan {
+        size_t begin = 0;
+        uint32_t size = 0;
+    };
+    // Forward index: entries of all documents back to back, those of a document sorted by word.
+    // Spans are addressed by ordinal. Removed documents leave holes, which are squeezed out
+    // once they take half of the entries
+    std::vector<ForwardEntry> forward_entries_;
+    std::vector<ForwardSpan> forward_spans_;
+    size_t removed_forward_entry_count_ = 0;
+    // Dictionary words by term id, empty for free ids
+    std::vector<std::string_view> term_words_;
+    RetrievalMode retrieval_mode_ = RetrievalMode::PRUNED;
+    uint64_t generation_ = 0;
 
 
-    bool IsStopWord(const std::string& word) const;
+    bool IsStopWord(std::string_view word) const;
 
-    static bool IsValidWord(const std::string& word);
+    static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string> SplitIntoWordsNoStop(const std::string& text) const;
+    // A lone '-' and words starting with "--" are not valid
+    static bool IsValidMinusPrefix(std::string_view word);
+
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    // Words of a query are views into the raw query text
     struct QueryWord {
-        std::string data;
+        std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(std::string text) const;
+    // Control characters are found by the tokenizer, which reads the query once
+    QueryWord ParseQueryWord(std::string_view text, bool has_control_characters) const;
 
     struct Query {
-        std::set<std::string> plus_words;
-        std::set<std::string> minus_words;
+        std::pmr::vector<std::string_view> plus_words;
+        std::pmr::vector<std::string_view> minus_words;
     };
 
-    Query ParseQuery(const std::string& text) const;
+    // Words are sorted and unique unless remove_duplicates is false.
+    // The word lists are allocated from resource, usually a QueryArena
+    Query ParseQuery(std::string_view text, std::pmr::memory_resource* resource, bool remove_duplicates = true) const;
+
+    static void SortUnique(std::pmr::vector<std::string_view>& words);
+
+    // Searches a query parsed with duplicates removed
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+        size_t top_count) const;
+
+    // Returns nullptr for words which are not in the index
+    const PostingsList* FindPostings(std::string_view word) const;
+
+    // Returns the dictionary entry of the word, adding it when the word is new
+    const std::pair<const std::pmr::string, size_t>& InternTerm(std::string_view word);
+
+    // Drops the terms left without postings and the document bookkeeping
+    void ForgetDocument(int document_id);
+
+    // Reserves the forward index entries of a new document, filled by the caller in word order
+    ForwardEntry* AppendForwardSpan(size_t size);
+
+    const ForwardEntry* GetForwardEntries(size_t document_ordinal) const;
+
+    // Returns the dictionary copy of the word, or an empty view unless the document contains it
+    std::string_view FindDocumentWord(size_t document_ordinal, std::string_view word) const;
+
+    void CompactForwardIndex();
+
+    // Renumbers the live documents in order, dropping the ordinals of removed ones
+    void CompactOrdinals();
 
-    // Existence required
-    double ComputeWordInverseDocumentFreq(const std::string& word) const;
+    // Posting of an AddDocuments batch before it is merged into the index
+    struct BatchPosting {
+        uint32_t term_id;
+        uint32_t occurrences;
+        size_t document_ordinal;
+
+        bool operator<(const BatchPosting& other) const;
+    };
+
+    // Distinct words of a text with their occurrences, sorted by word
+    std::vector<std::pair<std::string_view, uint32_t>> CountWordOccurrences(const std::vector<std::string_view>& words) const;
+
+    // Sums inv_word_count the way AddDocument does, so the result is exactly the stored frequency
+    static double ComputeTermFreq(uint32_t occurrences, double inv_word_count);
+
+    double ComputeWordInverseDocumentFreq(size_t term_id) const;
+
+    // Inverse document frequencies of the plus words in query order
+    std::pmr::vector<double> ComputeInverseDocumentFreqs(const Query& query, std::pmr::memory_resource* resource) const;
+
+    // Queries whose plus words have at least 1 / DENSE_ACCUMULATOR_RATIO postings per document
+    // are scored into a dense array, narrower ones into a hash table
+    static constexpr size_t DENSE_ACCUMULATOR_RATIO = 16;
+
+    // Documents excluded by the minus words of a query. Postings cheaper to decode than
+    // to probe go into a mask checked before scoring, the rest are probed per matched document
+    class MinusWordFilter {
+    public:
+        MinusWordFilter(size_t document_count, std::pmr::memory_resource* resource);
+
+        void Mask(const PostingsList& postings);
+
+        void Probe(const PostingsList& postings);
+
+        bool IsMasked(size_t document_ordinal) const;
+
+        bool IsProbed(size_t document_ordinal) const;
+
+    private:
+        size_t document_count_;
+        std::pmr::memory_resource* resource_;
+        // Allocated by the first masked word only
+        std::optional<DocumentBitmap> mask_;
+        std::pmr::vector<const PostingsList*> probed_postings_;
+    };
+
+    // Number of plus word postings, an upper bound of the matched document count
+    size_t CountPlusPostings(const Query& query) const;
+
+    bool IsDenseQuery(size_t plus_posting_count) const;
+
+    MinusWordFilter BuildMinusWordFilter(const Query& query, size_t plus_posting_count, std::pmr::memory_resource* resource) const;
+
+    template <typename DocumentPredicate>
+    static constexpr bool IS_COLUMN_PREDICATE = std::is_same_v<DocumentPredicate, DocumentStatusPredicate>
+        || std::is_same_v<DocumentPredicate, DocumentRatingPredicate>;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const ;
+    bool IsAccepted(DocumentPredicate& document_predicate, size_t document_ordinal) const;
+
+    template <typename DocumentPredicate, typename Accumulator>
+    void AccumulateRelevance(const PostingsList& postings, const PostingsList::Block& block, double inverse_document_freq, const MinusWordFilter& minus_word_filter,
+        DocumentPredicate& document_predicate, Accumulator& accumulator) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate) const ;
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(ExecutionPolicy&& policy, const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate) const ;
+
+    // Pruning pays off when most postings belong to frequent words with low score bounds,
+    // which rare words outscore. Other queries are scored faster term at a time
+    bool IsPrunable(const Query& query, const std::pmr::vector<double>& inverse_document_freqs, size_t top_count) const;
+
+    static constexpr size_t PRUNING_MIN_POSTING_COUNT = 1024;
+
+    // Documents are pruned only when they lose to the top by more than the tie tolerance,
+    // so the rating and id order of SelectTopDocuments stays intact
+    inline static const double PRUNING_MARGIN = 2 * OBSERVATIONAL_ERROR;
+
+    // Document at a time retrieval with MaxScore pruning. Returns in ordinal order the matched
+    // documents which may be among the top_count best, with relevances summed as FindAllDocuments does
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopCandidates(const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate, size_t top_count) const;
+
+    template <typename Accumulator>
+    std::vector<Document> CollectMatchedDocuments(const Accumulator& accumulator, const MinusWordFilter& minus_word_filter) const;
+
+    // Leaves only the top_count best documents, ordered by relevance, then rating, then id
+    static void SelectTopDocuments(std::vector<Document>& documents, size_t top_count);
+};
+
+// Words of a document sorted, each with its term frequency. Both are restored from the
+// forward index while iterating, words are views into the dictionary
+class SearchServer::WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        value_type operator*() const;
+
+        Iterator& operator++();
+
+        Iterator operator++(int);
+
+        bool operator==(const Iterator& other) const;
+
+        bool operator!=(const Iterator& other) const;
+
+    private:
+        friend class WordFrequencies;
+
+        const ForwardEntry* entry_ = nullptr;
+        const std::string_view* term_words_ = nullptr;
+        double inv_word_count_ = 0.0;
+
+        Iterator(const ForwardEntry* entry, const std::string_view* term_words, double inv_word_count);
+    };
+
+    WordFrequencies() = default;
+
+    Iterator begin() const;
+
+    Iterator end() const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+private:
+    friend class SearchServer;
+
+    const ForwardEntry* entries_ = nullptr;
+    size_t size_ = 0;
+    const std::string_view* term_words_ = nullptr;
+    double inv_word_count_ = 0.0;
+
+    WordFrequencies(const ForwardEntry* entries, size_t size, const std::string_view* term_words, double inv_word_count);
 };
 
     template <typename StringContainer>
     SearchServer::SearchServer(const StringContainer& stop_words)
         : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
     {
-        for (const std::string& word : stop_words) {
-            if (!IsValidWord(word)) {
-                throw std::invalid_argument("недопустимые символы в стоп слове:" + word);
+        for (const std::string_view word : stop_words) {
+            if (!word.empty() && !IsValidWord(word)) {
+                throw std::invalid_argument("недопустимые символы в стоп слове:" + std::string(word));
             }
         }
     }
 
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindTopDocuments(const std::string& raw_query, DocumentPredicate document_predicate) const {
-        Query query = ParseQuery(raw_query);
-        auto matched_documents = FindAllDocuments(query, document_predicate);
+    std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+        return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+    }
 
-        sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < OBSERVATIONAL_ERROR) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-            });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-        }
+    template <typename ExecutionPolicy>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status,
+        size_t top_count) const {
+        return FindTopDocuments(policy, raw_query, DocumentStatusPredicate{ status }, top_count);
+    }
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const {
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate,
+        size_t top_count) const {
+        SEARCH_METRICS_STAGE(SearchStage::FIND_TOP_DOCUMENTS);
+        QueryArena arena;
+        const Query query = ParseQuery(raw_query, arena.GetResource());
+        return FindTopDocuments(policy, query, document_predicate, top_count);
+    }
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const Query& query, DocumentPredicate document_predicate,
+        size_t top_count) const {
+        QueryArena arena;
+        const auto inverse_document_freqs = ComputeInverseDocumentFreqs(query, arena.GetResource());
+        constexpr bool is_sequential = std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>;
+        auto matched_documents = is_sequential && IsPrunable(query, inverse_document_freqs, top_count)
+            ? FindTopCandidates(query, inverse_document_freqs, document_predicate, top_count)
+            : FindAllDocuments(policy, query, inverse_document_freqs, document_predicate);
+        SelectTopDocuments(matched_documents, top_count);
 
         // Exchange matched_documents and result instead of deep copying
         return matched_documents;
     }
     
     template <typename DocumentPredicate>
-    std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-        std::map<int, double> document_to_relevance;
-        for (const std::string& word : query.plus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
-                continue;
+    std::vector<Document> SearchServer::FindAllDocuments(const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate) const {
+        QueryArena arena;
+        const size_t plus_posting_count = CountPlusPostings(query);
+        const MinusWordFilter minus_word_filter = BuildMinusWordFilter(query, plus_posting_count, arena.GetResource());
+        SEARCH_METRICS_POSTINGS(plus_posting_count);
+        const auto find_all_documents = [&](auto& accumulator) {
+            {
+                SEARCH_METRICS_STAGE(SearchStage::POSTINGS_SCAN);
+                for (size_t i = 0; i < query.plus_words.size(); ++i) {
+                    if (const auto* postings = FindPostings(query.plus_words[i])) {
+                        for (const PostingsList::Block& block : postings->GetBlocks()) {
+                            AccumulateRelevance(*postings, block, inverse_document_freqs[i], minus_word_filter, document_predicate, accumulator);
+                        }
+                    }
+                }
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            SEARCH_METRICS_STAGE(SearchStage::SCORING);
+            return CollectMatchedDocuments(accumulator, minus_word_filter);
+        };
+        if (IsDenseQuery(plus_posting_count)) {
+            DenseRelevanceAccumulator accumulator(documents_.size(), arena.GetResource());
+            return find_all_documents(accumulator);
+        }
+        HashRelevanceAccumulator accumulator(plus_posting_count, arena.GetResource());
+        return find_all_documents(accumulator);
+    }
+
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindAllDocuments(ExecutionPolicy&& policy, const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate) const {
+        if constexpr (std::is_same_v<std::decay_t<ExecutionPolicy>, std::execution::sequenced_policy>) {
+            return FindAllDocuments(query, inverse_document_freqs, document_predicate);
+        }
+        else {
+            const size_t plus_posting_count = CountPlusPostings(query);
+            // Narrow queries are not worth the threads
+            if (!IsDenseQuery(plus_posting_count)) {
+                return FindAllDocuments(query, inverse_document_freqs, document_predicate);
+            }
+            SEARCH_METRICS_POSTINGS(plus_posting_count);
+            QueryArena arena;
+            const MinusWordFilter minus_word_filter = BuildMinusWordFilter(query, plus_posting_count, arena.GetResource());
+            DenseRelevanceAccumulator accumulator(documents_.size(), arena.GetResource());
+            {
+                SEARCH_METRICS_STAGE(SearchStage::POSTINGS_SCAN);
+                for (size_t i = 0; i < query.plus_words.size(); ++i) {
+                    const auto* postings = FindPostings(query.plus_words[i]);
+                    if (postings == nullptr) {
+                        continue;
+                    }
+                    // Blocks of a postings list hold different documents, so they are scored concurrently.
+                    // Words are still visited one by one, every relevance gets its terms added in the sequential order
+                    std::for_each(policy, postings->GetBlocks().begin(), postings->GetBlocks().end(),
+                        [&](const PostingsList::Block& block) {
+                            AccumulateRelevance(*postings, block, inverse_document_freqs[i], minus_word_filter, document_predicate, accumulator);
+                        });
                 }
             }
+            SEARCH_METRICS_STAGE(SearchStage::SCORING);
+            return CollectMatchedDocuments(accumulator, minus_word_filter);
         }
+    }
 
-        for (const std::string& word : query.minus_words) {
-            if (word_to_document_freqs_.count(word) == 0) {
+    template <typename DocumentPredicate, typename Accumulator>
+    void SearchServer::AccumulateRelevance(const PostingsList& postings, const PostingsList::Block& block, double inverse_document_freq, const MinusWordFilter& minus_word_filter,
+        DocumentPredicate& document_predicate, Accumulator& accumulator) const {
+        if constexpr (IS_COLUMN_PREDICATE<DocumentPredicate>) {
+            // The predicate runs over the whole block first as a branch-free loop over a column
+            std::array<size_t, PostingsList::BLOCK_SIZE> document_ordinals;
+            std::array<uint32_t, PostingsList::BLOCK_SIZE> occurrences;
+            std::array<bool, PostingsList::BLOCK_SIZE> is_accepted;
+            size_t size = 0;
+            postings.ForEach(block, [&](size_t document_ordinal, uint32_t document_occurrences) {
+                document_ordinals[size] = document_ordinal;
+                occurrences[size] = document_occurrences;
+                ++size;
+            });
+            for (size_t i = 0; i < size; ++i) {
+                is_accepted[i] = IsAccepted(document_predicate, document_ordinals[i]);
+            }
+            for (size_t i = 0; i < size; ++i) {
+                if (is_accepted[i] && !minus_word_filter.IsMasked(document_ordinals[i])) {
+                    accumulator.Add(document_ordinals[i],
+                        ComputeTermFreq(occurrences[i], documents_[document_ordinals[i]].inv_word_count) * inverse_document_freq);
+                }
+            }
+        }
+        else {
+            postings.ForEach(block, [&](size_t document_ordinal, uint32_t occurrences) {
+                if (!minus_word_filter.IsMasked(document_ordinal) && IsAccepted(document_predicate, document_ordinal)) {
+                    accumulator.Add(document_ordinal,
+                        ComputeTermFreq(occurrences, documents_[document_ordinal].inv_word_count) * inverse_document_freq);
+                }
+            });
+        }
+    }
+
+    template <typename DocumentPredicate>
+    bool SearchServer::IsAccepted(DocumentPredicate& document_predicate, size_t document_ordinal) const {
+        if constexpr (std::is_same_v<DocumentPredicate, DocumentStatusPredicate>) {
+            return document_statuses_[document_ordinal] == document_predicate.status;
+        }
+        else if constexpr (std::is_same_v<DocumentPredicate, DocumentRatingPredicate>) {
+            const int rating = document_ratings_[document_ordinal];
+            return document_predicate.min_rating <= rating && rating <= document_predicate.max_rating;
+        }
+        else {
+            return document_predicate(documents_[document_ordinal].id, document_statuses_[document_ordinal],
+                document_ratings_[document_ordinal]);
+        }
+    }
+
+    template <typename DocumentPredicate>
+    std::vector<Document> SearchServer::FindTopCandidates(const Query& query, const std::pmr::vector<double>& inverse_document_freqs,
+        DocumentPredicate document_predicate, size_t top_count) const {
+        SEARCH_METRICS_STAGE(SearchStage::POSTINGS_SCAN);
+        QueryArena arena;
+        std::pmr::memory_resource* resource = arena.GetResource();
+        const MinusWordFilter minus_word_filter = BuildMinusWordFilter(query, CountPlusPostings(query), resource);
+
+        // Terms go by increasing score upper bound. The first non_essential_count terms together
+        // cannot lift a document into the top, so only the others propose documents
+        struct Term {
+            size_t word_index;
+            double max_score;
+            PostingsList::Cursor cursor;
+        };
+        std::pmr::vector<Term> terms(resource);
+        terms.reserve(query.plus_words.size());
+        for (size_t i = 0; i < query.plus_words.size(); ++i) {
+            const auto it = term_ids_.find(query.plus_words[i]);
+            if (it != term_ids_.end()) {
+                const double max_score = term_stats_[it->second].max_term_freq * inverse_document_freqs[i];
+                terms.push_back({ i, max_score, PostingsList::Cursor(postings_[it->second]) });
+            }
+        }
+        std::sort(terms.begin(), terms.end(), [](const Term& lhs, const Term& rhs) {
+            return lhs.max_score < rhs.max_score;
+        });
+        std::pmr::vector<double> max_score_prefix_sums(terms.size() + 1, 0.0, resource);
+        for (size_t i = 0; i < terms.size(); ++i) {
+            max_score_prefix_sums[i + 1] = max_score_prefix_sums[i] + terms[i].max_score;
+        }
+
+        // Min-heap of the top_count best relevances, scores below threshold cannot enter it
+        std::pmr::vector<double> top_relevances(resource);
+        double threshold = -std::numeric_limits<double>::infinity();
+        size_t non_essential_count = 0;
+        std::pmr::vector<double> word_scores(query.plus_words.size(), resource);
+        // Postings whose occurrences were read, the skipped ones are not counted
+        size_t touched_posting_count = 0;
+        std::vector<Document> candidates;
+        while (true) {
+            size_t document_ordinal = std::numeric_limits<size_t>::max();
+            for (size_t i = non_essential_count; i < terms.size(); ++i) {
+                if (!terms[i].cursor.AtEnd()) {
+                    document_ordinal = std::min(document_ordinal, terms[i].cursor.GetOrdinal());
+                }
+            }
+            if (document_ordinal == std::numeric_limits<size_t>::max()) {
+                break;
+            }
+
+            const auto& document_data = documents_[document_ordinal];
+            const bool is_excluded = minus_word_filter.IsMasked(document_ordinal) || !IsAccepted(document_predicate, document_ordinal);
+            const auto score_term = [&](Term& term) {
+                const double word_score = ComputeTermFreq(term.cursor.GetOccurrences(), document_data.inv_word_count)
+                    * inverse_document_freqs[term.word_index];
+                word_scores[term.word_index] = word_score;
+                return word_score;
+            };
+            std::fill(word_scores.begin(), word_scores.end(), 0.0);
+            double score = 0.0;
+            for (size_t i = non_essential_count; i < terms.size(); ++i) {
+                PostingsList::Cursor& cursor = terms[i].cursor;
+                if (!cursor.AtEnd() && cursor.GetOrdinal() == document_ordinal) {
+                    ++touched_posting_count;
+                    if (!is_excluded) {
+                        score += score_term(terms[i]);
+                    }
+                    cursor.Next();
+                }
+            }
+            if (is_excluded) {
+                continue;
+            }
+            // Non-essential terms are looked up from the largest bound down while they can still matter
+            bool is_pruned = false;
+            for (size_t i = non_essential_count; i-- > 0;) {
+                if (score + max_score_prefix_sums[i + 1] < threshold) {
+                    is_pruned = true;
+                    break;
+                }
+                PostingsList::Cursor& cursor = terms[i].cursor;
+                cursor.SkipTo(document_ordinal);
+                if (!cursor.AtEnd() && cursor.GetOrdinal() == document_ordinal) {
+                    ++touched_posting_count;
+                    score += score_term(terms[i]);
+                }
+            }
+            if (is_pruned || score < threshold || minus_word_filter.IsProbed(document_ordinal)) {
                 continue;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+
+            // Summed in query word order, so the relevance equals the exhaustive one exactly
+            double relevance = 0.0;
+            for (const double word_score : word_scores) {
+                relevance += word_score;
+            }
+            candidates.push_back({ document_data.id, relevance, document_ratings_[document_ordinal] });
+            if (top_relevances.size() < top_count) {
+                top_relevances.push_back(relevance);
+                std::push_heap(top_relevances.begin(), top_relevances.end(), std::greater<>{});
+            }
+            else if (relevance > top_relevances.front()) {
+                std::pop_heap(top_relevances.begin(), top_relevances.end(), std::greater<>{});
+                top_relevances.back() = relevance;
+                std::push_heap(top_relevances.begin(), top_relevances.end(), std::greater<>{});
+            }
+            if (top_relevances.size() == top_count) {
+                threshold = top_relevances.front() - PRUNING_MARGIN;
+                while (non_essential_count < terms.size() && max_score_prefix_sums[non_essential_count + 1] < threshold) {
+                    ++non_essential_count;
+                }
             }
         }
+        SEARCH_METRICS_POSTINGS(touched_posting_count);
+        return candidates;
+    }
 
+    template <typename Accumulator>
+    std::vector<Document> SearchServer::CollectMatchedDocuments(const Accumulator& accumulator, const MinusWordFilter& minus_word_filter) const {
         std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
-        }
+        accumulator.ForEach([&](size_t document_ordinal, double relevance) {
+            if (!minus_word_filter.IsProbed(document_ordinal)) {
+                matched_documents.push_back({ documents_[document_ordinal].id, relevance, document_ratings_[document_ordinal] });
+            }
+        });
         return matched_documents;
-    }
\ No newline at end of file
+    }
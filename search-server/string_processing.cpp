@@ -1,23 +1,99 @@
 #include "string_processing.h"
 
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STRING_PROCESSING_X86
+#endif
+
 using namespace std;
-vector<string> SplitIntoWords(const string& text) {
-    vector<string> words;
-    string word;
-    for (const char c : text) {
-        if (c == ' ') {
-            if (!word.empty()) {
-                words.push_back(word);
-                word.clear();
-            }
-        }
-        else {
-            word += c;
-        }
+
+namespace {
+
+using TextScanner = void (*)(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits);
+
+// Adds the bits of text[offset, size) to the cleared bitmaps
+void ScanTextScalar(const char* text, size_t offset, size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    for (size_t i = offset; i < size; ++i) {
+        const uint8_t c = static_cast<uint8_t>(text[i]);
+        space_bits[i / 64] |= static_cast<uint64_t>(c == ' ') << (i % 64);
+        control_bits[i / 64] |= static_cast<uint64_t>(c < ' ') << (i % 64);
     }
-    if (!word.empty()) {
-        words.push_back(word);
+}
+
+void ClearBits(size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    const size_t word_count = (size + 63) / 64;
+    memset(space_bits, 0, word_count * sizeof(uint64_t));
+    memset(control_bits, 0, word_count * sizeof(uint64_t));
+}
+
+void ScanTextPlain(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    ClearBits(size, space_bits, control_bits);
+    ScanTextScalar(text, 0, size, space_bits, control_bits);
+}
+
+#ifdef STRING_PROCESSING_X86
+
+// Bytes 0x00-0x1F are the only ones without the three high bits set
+void ScanTextSse2(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    ClearBits(size, space_bits, control_bits);
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i high_bits = _mm_set1_epi8(static_cast<char>(0xE0));
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const uint64_t space_mask = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)));
+        const uint64_t control_mask = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, high_bits), zero)));
+        space_bits[i / 64] |= space_mask << (i % 64);
+        control_bits[i / 64] |= control_mask << (i % 64);
     }
+    ScanTextScalar(text, i, size, space_bits, control_bits);
+}
 
+__attribute__((target("avx2")))
+void ScanTextAvx2(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    ClearBits(size, space_bits, control_bits);
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i high_bits = _mm256_set1_epi8(static_cast<char>(0xE0));
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        const uint64_t space_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, spaces)));
+        const uint64_t control_mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(bytes, high_bits), zero)));
+        space_bits[i / 64] |= space_mask << (i % 64);
+        control_bits[i / 64] |= control_mask << (i % 64);
+    }
+    ScanTextScalar(text, i, size, space_bits, control_bits);
+}
+
+#endif
+
+TextScanner ChooseTextScanner() {
+#ifdef STRING_PROCESSING_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanTextAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ScanTextSse2;
+    }
+#endif
+    return ScanTextPlain;
+}
+
+}  // namespace
+
+void ScanText(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits) {
+    static const TextScanner text_scanner = ChooseTextScanner();
+    text_scanner(text, size, space_bits, control_bits);
+}
+
+vector<string_view> SplitIntoWords(string_view text) {
+    vector<string_view> words;
+    ForEachWord(text, [&words](string_view word) {
+        words.push_back(word);
+    });
     return words;
-}
\ No newline at end of file
+}
@@ -1,18 +1,104 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <set>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
 
-std::vector<std::string> SplitIntoWords(const std::string& text);
+// Sets bit i % 64 of space_bits[i / 64] for every space text[i] and the same bit of
+// control_bits for every control character, clearing the other bits of the words written.
+// Runs on AVX2, SSE2 or plain code, whichever is the best the CPU supports
+void ScanText(const char* text, size_t size, uint64_t* space_bits, uint64_t* control_bits);
+
+// Index of the lowest set bit, value must not be zero
+inline int CountTrailingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    int index = 0;
+    for (; (value & 1) == 0; value >>= 1) {
+        ++index;
+    }
+    return index;
+#endif
+}
+
+// Calls action(word, has_control_characters) for every space separated word of text.
+// The words are views into text, the text is read once
+template <typename Action>
+void ForEachCheckedWord(std::string_view text, Action action) {
+    constexpr size_t CHUNK_SIZE = 1024;
+    std::array<uint64_t, CHUNK_SIZE / 64> space_bits;
+    std::array<uint64_t, CHUNK_SIZE / 64> control_bits;
+    // A word may go on over several chunks
+    size_t word_begin = text.npos;
+    bool has_control_characters = false;
+    for (size_t chunk_begin = 0; chunk_begin < text.size(); chunk_begin += CHUNK_SIZE) {
+        const size_t chunk_size = std::min(CHUNK_SIZE, text.size() - chunk_begin);
+        ScanText(text.data() + chunk_begin, chunk_size, space_bits.data(), control_bits.data());
+        for (size_t bits_index = 0; bits_index * 64 < chunk_size; ++bits_index) {
+            const size_t bits_begin = chunk_begin + bits_index * 64;
+            const size_t bits_size = std::min<size_t>(64, text.size() - bits_begin);
+            const uint64_t spaces = space_bits[bits_index];
+            const uint64_t controls = control_bits[bits_index];
+            // Bits past the end of the text count as spaces
+            const uint64_t non_spaces = ~spaces & (bits_size == 64 ? ~uint64_t{ 0 } : (uint64_t{ 1 } << bits_size) - 1);
+            size_t position = 0;
+            while (position < 64) {
+                if (word_begin == text.npos) {
+                    const uint64_t rest = non_spaces >> position;
+                    if (rest == 0) {
+                        break;
+                    }
+                    position += CountTrailingZeros(rest);
+                    word_begin = bits_begin + position;
+                    has_control_characters = false;
+                }
+                const uint64_t rest = ~non_spaces >> position;
+                const size_t word_end = rest == 0 ? 64 : position + CountTrailingZeros(rest);
+                const uint64_t word_bits = word_end - position == 64
+                    ? ~uint64_t{ 0 }
+                    : ((uint64_t{ 1 } << (word_end - position)) - 1) << position;
+                has_control_characters = has_control_characters || (controls & word_bits) != 0;
+                if (word_end == 64 && bits_begin + 64 < text.size()) {
+                    break;
+                }
+                action(text.substr(word_begin, bits_begin + word_end - word_begin), has_control_characters);
+                word_begin = text.npos;
+                position = word_end;
+            }
+        }
+    }
+}
+
+// Calls action for every space separated word of text. The words are views into text
+template <typename Action>
+void ForEachWord(std::string_view text, Action action) {
+    ForEachCheckedWord(text, [&action](std::string_view word, bool) {
+        action(word);
+    });
+}
+
+std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
 template <typename StringContainer>
-std::set<std::string> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
-    std::set<std::string> non_empty_strings;
-    for (const std::string& str : strings) {
+std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
+    std::set<std::string, std::less<>> non_empty_strings;
+    for (const std::string_view str : strings) {
         if (!str.empty()) {
-            non_empty_strings.insert(str);
+            non_empty_strings.emplace(str);
         }
     }
     return non_empty_strings;
-}
\ No newline at end of file
+}
@@ -1 +1,44 @@
-// в качестве заготовки кода используйте последнюю версию своей поисковой системы
\ No newline at end of file
+#include "test_example_functions.h"
+
+#include <iostream>
+
+#include "log_duration.h"
+
+using namespace std;
+
+void AddDocument(SearchServer& search_server, int document_id, const string& document, DocumentStatus status,
+    const vector<int>& ratings) {
+    try {
+        search_server.AddDocument(document_id, document, status, ratings);
+    }
+    catch (const exception& e) {
+        cout << "Ошибка добавления документа "s << document_id << ": "s << e.what() << endl << endl;
+    }
+}
+
+void FindTopDocuments(const SearchServer& search_server, const string& raw_query) {
+    LOG_DURATION("Operation time"s);
+    cout << "Результаты поиска по запросу: "s << raw_query << endl;
+    try {
+        for (const Document& document : search_server.FindTopDocuments(raw_query)) {
+            PrintDocument(document);
+        }
+    }
+    catch (const exception& e) {
+        cout << "Ошибка поиска: "s << e.what() << endl << endl;
+    }
+}
+
+void MatchDocuments(const SearchServer& search_server, const string& query) {
+    LOG_DURATION("Operation time"s);
+    try {
+        cout << "Матчинг документов по запросу: "s << query << endl;
+        for (const int document_id : search_server) {
+            const auto [words, status] = search_server.MatchDocument(query, document_id);
+            PrintMatchDocumentResult(document_id, words, status);
+        }
+    }
+    catch (const exception& e) {
+        cout << "Ошибка матчинга документов на запрос "s << query << ": "s << e.what() << endl << endl;
+    }
+}
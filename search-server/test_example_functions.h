@@ -1 +1,13 @@
-#pragma once
\ No newline at end of file
+#pragma once
+#include <string>
+#include <vector>
+
+#include "search_server.h"
+
+// Report errors to cout instead of throwing, the search and matching also print their time to cerr
+void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status,
+    const std::vector<int>& ratings);
+
+void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query);
+
+void MatchDocuments(const SearchServer& search_server, const std::string& query);
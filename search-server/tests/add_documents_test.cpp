@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../benchmarks/corpus_generator.h"
+#include "../search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on the"s;
+const int VOCABULARY_SIZE = 800;
+
+// A few texts carry control characters, which AddDocument rejects
+vector<string> MakeTexts(mt19937& generator, const ZipfGenerator& zipf, int count) {
+    vector<string> texts;
+    for (int i = 0; i < count; ++i) {
+        string text;
+        for (int j = 1 + generator() % 15; j > 0; --j) {
+            text += MakeWord(zipf(generator)) + ' ';
+        }
+        if (generator() % 200 == 0) {
+            text += "x\x01y"s;
+        }
+        texts.push_back(text);
+    }
+    return texts;
+}
+
+// Ids come from a small range, so they repeat inside a batch and across batches, a few are negative
+vector<NewDocument> MakeBatch(mt19937& generator, const vector<string>& texts) {
+    vector<NewDocument> documents;
+    for (const string& text : texts) {
+        const int document_id = static_cast<int>(generator() % 30000) - 5;
+        documents.push_back({ document_id, text, static_cast<DocumentStatus>(generator() % 4),
+            { static_cast<int>(generator() % 10) - 3, 4 } });
+    }
+    return documents;
+}
+
+// Errors of adding the documents one by one, in the order AddDocuments reports them
+vector<AddDocumentError> AddSequentially(SearchServer& search_server, const vector<NewDocument>& documents) {
+    vector<AddDocumentError> errors;
+    for (const NewDocument& document : documents) {
+        try {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        catch (const invalid_argument& e) {
+            errors.push_back({ document.id, e.what() });
+        }
+    }
+    return errors;
+}
+
+bool IsEqual(const vector<AddDocumentError>& lhs, const vector<AddDocumentError>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const AddDocumentError& a, const AddDocumentError& b) {
+        return a.document_id == b.document_id && a.message == b.message;
+    });
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Counts the documents and queries on which the servers differ
+int CountMismatches(const SearchServer& sequential, const SearchServer& bulk, const vector<string>& queries) {
+    int mismatches = sequential.GetDocumentCount() == bulk.GetDocumentCount() ? 0 : 1;
+    if (!equal(sequential.begin(), sequential.end(), bulk.begin(), bulk.end())) {
+        return mismatches + 1;
+    }
+    for (const int document_id : sequential) {
+        const auto frequencies = sequential.GetWordFrequencies(document_id);
+        const auto bulk_frequencies = bulk.GetWordFrequencies(document_id);
+        if (!equal(frequencies.begin(), frequencies.end(), bulk_frequencies.begin(), bulk_frequencies.end())) {
+            ++mismatches;
+        }
+    }
+    for (const string& query : queries) {
+        if (!IsEqual(sequential.FindTopDocuments(query), bulk.FindTopDocuments(query))
+            || !IsEqual(sequential.FindTopDocuments(query, DocumentStatus::BANNED), bulk.FindTopDocuments(query, DocumentStatus::BANNED))) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(7);
+    const ZipfGenerator zipf(VOCABULARY_SIZE, 1.0);
+    CorpusOptions corpus_options;
+    corpus_options.vocabulary_size = VOCABULARY_SIZE;
+    QueryOptions query_options;
+    query_options.query_count = 300;
+    query_options.minus_word_ratio = 0.2;
+    const vector<string> queries = GenerateQueries(corpus_options, query_options);
+
+    SearchServer sequential(STOP_WORDS);
+    SearchServer bulk(STOP_WORDS);
+    // An empty batch first, then batches landing on a server that already holds documents
+    for (const int count : { 0, 5000, 5000, 1 }) {
+        const vector<string> texts = MakeTexts(generator, zipf, count);
+        const vector<NewDocument> documents = MakeBatch(generator, texts);
+        const vector<AddDocumentError> expected_errors = AddSequentially(sequential, documents);
+        if (!IsEqual(bulk.AddDocuments(documents), expected_errors)) {
+            cerr << "AddDocuments reported other errors than AddDocument for a batch of " << count << endl;
+            return 1;
+        }
+        for (int document_id = 0; document_id < 30000; document_id += 11) {
+            if (binary_search(sequential.begin(), sequential.end(), document_id)) {
+                sequential.RemoveDocument(document_id);
+                bulk.RemoveDocument(document_id);
+            }
+        }
+        const int mismatches = CountMismatches(sequential, bulk, queries);
+        if (mismatches > 0) {
+            cerr << "AddDocuments and AddDocument give different servers in " << mismatches << " checks" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
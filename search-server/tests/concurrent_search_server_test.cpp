@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../benchmarks/corpus_generator.h"
+#include "../concurrent_search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on the"s;
+const int VOCABULARY_SIZE = 500;
+
+string MakeText(mt19937& generator, const ZipfGenerator& zipf) {
+    string text;
+    for (int i = 1 + generator() % 10; i > 0; --i) {
+        text += MakeWord(zipf(generator)) + ' ';
+    }
+    return text;
+}
+
+vector<string> MakeQueries() {
+    CorpusOptions corpus_options;
+    corpus_options.vocabulary_size = VOCABULARY_SIZE;
+    QueryOptions options;
+    options.query_count = 200;
+    options.minus_word_ratio = 0.2;
+    return GenerateQueries(corpus_options, options);
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Counts the queries whose results or matches differ between the servers
+int CountMismatches(const SearchServer& search_server, const ConcurrentSearchServer& concurrent,
+    const vector<int>& document_ids, const vector<string>& queries) {
+    const auto is_even_rated = [](int document_id, DocumentStatus, int rating) {
+        return document_id % 2 == 0 && rating > 3;
+    };
+    int mismatches = search_server.GetDocumentCount() == concurrent.GetDocumentCount() ? 0 : 1;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const string& query = queries[i];
+        if (!IsEqual(search_server.FindTopDocuments(query), concurrent.FindTopDocuments(query))
+            || !IsEqual(search_server.FindTopDocuments(query, DocumentStatus::BANNED), concurrent.FindTopDocuments(query, DocumentStatus::BANNED))
+            || !IsEqual(search_server.FindTopDocuments(execution::seq, query, is_even_rated, 20),
+                concurrent.FindTopDocuments(query, is_even_rated, 20))) {
+            ++mismatches;
+            continue;
+        }
+        if (document_ids.empty()) {
+            continue;
+        }
+        const int document_id = document_ids[i % document_ids.size()];
+        const auto [words, status] = search_server.MatchDocument(query, document_id);
+        const auto [concurrent_words, concurrent_status] = concurrent.MatchDocument(query, document_id);
+        if (!equal(words.begin(), words.end(), concurrent_words.begin(), concurrent_words.end()) || status != concurrent_status) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+// Adds and removes the same documents on both servers, comparing them every few hundred changes
+bool TestInterleavedChanges(const vector<string>& queries) {
+    mt19937 generator(3);
+    const ZipfGenerator zipf(VOCABULARY_SIZE, 1.0);
+    SearchServer search_server(STOP_WORDS);
+    ConcurrentSearchServer concurrent(STOP_WORDS, 7);
+    vector<int> document_ids;
+    int next_document_id = 0;
+    for (int change = 1; change <= 4000; ++change) {
+        if (!document_ids.empty() && generator() % 3 == 0) {
+            const size_t index = generator() % document_ids.size();
+            search_server.RemoveDocument(document_ids[index]);
+            concurrent.RemoveDocument(document_ids[index]);
+            document_ids[index] = document_ids.back();
+            document_ids.pop_back();
+        }
+        else {
+            // Ids are sparse, so that shards get uneven numbers of documents
+            next_document_id += 1 + generator() % 5;
+            const string text = MakeText(generator, zipf);
+            const DocumentStatus status = static_cast<DocumentStatus>(generator() % 4);
+            const vector<int> ratings = { static_cast<int>(generator() % 10) };
+            search_server.AddDocument(next_document_id, text, status, ratings);
+            concurrent.AddDocument(next_document_id, text, status, ratings);
+            document_ids.push_back(next_document_id);
+        }
+        if (change % 500 == 0) {
+            const int mismatches = CountMismatches(search_server, concurrent, document_ids, queries);
+            if (mismatches > 0) {
+                cerr << "concurrent server differs from the plain one on " << mismatches << " queries after "
+                    << change << " changes" << endl;
+                return false;
+            }
+        }
+    }
+    bool is_rejected = false;
+    try {
+        concurrent.AddDocument(document_ids.front(), "duplicate"s, DocumentStatus::ACTUAL, {});
+    }
+    catch (const invalid_argument&) {
+        is_rejected = true;
+    }
+    if (!is_rejected) {
+        cerr << "concurrent server accepted a duplicate id" << endl;
+        return false;
+    }
+    return true;
+}
+
+// Queries running while documents are added and removed must neither fail nor see
+// a half-applied change, and the server must end up as if the changes ran alone
+bool TestChangesWhileQueried(const vector<string>& queries) {
+    mt19937 generator(5);
+    const ZipfGenerator zipf(VOCABULARY_SIZE, 1.0);
+    SearchServer search_server(STOP_WORDS);
+    ConcurrentSearchServer concurrent(STOP_WORDS, 4);
+    for (int document_id = 0; document_id < 1000; ++document_id) {
+        const string text = MakeText(generator, zipf);
+        search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1 });
+        concurrent.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1 });
+    }
+
+    atomic<bool> is_changed = false;
+    atomic<int> failures = 0;
+    vector<thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&, i]() {
+            size_t query_index = i;
+            do {
+                try {
+                    const vector<Document> documents = concurrent.FindTopDocuments(queries[query_index++ % queries.size()]);
+                    // Every change leaves 1000 or 1001 documents, which all have the rating 1
+                    const size_t document_count = concurrent.GetDocumentCount();
+                    const bool is_consistent = is_sorted(documents.begin(), documents.end(), [](const Document& lhs, const Document& rhs) {
+                        return lhs.relevance > rhs.relevance;
+                    }) && all_of(documents.begin(), documents.end(), [](const Document& document) {
+                        return document.rating == 1;
+                    }) && (document_count == 1000 || document_count == 1001);
+                    failures += is_consistent ? 0 : 1;
+                }
+                catch (const exception&) {
+                    ++failures;
+                }
+            } while (!is_changed);
+        });
+    }
+    for (int document_id = 1000; document_id < 1200; ++document_id) {
+        const string text = MakeText(generator, zipf);
+        search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1 });
+        concurrent.AddDocument(document_id, text, DocumentStatus::ACTUAL, { 1 });
+        search_server.RemoveDocument(document_id - 1000);
+        concurrent.RemoveDocument(document_id - 1000);
+    }
+    is_changed = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    if (failures > 0) {
+        cerr << failures << " queries failed or saw a partial change" << endl;
+        return false;
+    }
+    vector<int> document_ids;
+    for (const int document_id : search_server) {
+        document_ids.push_back(document_id);
+    }
+    if (CountMismatches(search_server, concurrent, document_ids, queries) > 0) {
+        cerr << "concurrent server changed while queried differs from the plain one" << endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    const vector<string> queries = MakeQueries();
+    return TestInterleavedChanges(queries) && TestChangesWhileQueried(queries) ? 0 : 1;
+}
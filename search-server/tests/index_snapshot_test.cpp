@@ -0,0 +1,226 @@
+#include <atomic>
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../benchmarks/corpus_generator.h"
+#include "../index_snapshot.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on the"s;
+
+SearchServer MakeServer(uint32_t seed) {
+    CorpusOptions options;
+    options.document_count = 3000;
+    options.vocabulary_size = 2000;
+    options.seed = seed;
+    SearchServer search_server(STOP_WORDS);
+    for (const GeneratedDocument& document : GenerateCorpus(options)) {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    // Removed documents leave ordinals the snapshot has to skip
+    for (int document_id = 0; document_id < options.document_count; document_id += 7) {
+        search_server.RemoveDocument(document_id);
+    }
+    return search_server;
+}
+
+vector<string> MakeQueries() {
+    CorpusOptions corpus_options;
+    corpus_options.vocabulary_size = 2000;
+    QueryOptions options;
+    options.query_count = 300;
+    options.minus_word_ratio = 0.2;
+    return GenerateQueries(corpus_options, options);
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Counts the queries whose results or matches differ between the servers
+int CountMismatches(const SearchServer& search_server, const MappedSearchServer& mapped, const vector<string>& queries) {
+    const auto is_even_rated = [](int document_id, DocumentStatus, int rating) {
+        return document_id % 2 == 0 && rating > 0;
+    };
+    int mismatches = search_server.GetDocumentCount() == mapped.GetDocumentCount() ? 0 : 1;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const string& query = queries[i];
+        const bool is_equal = IsEqual(search_server.FindTopDocuments(query), mapped.FindTopDocuments(query))
+            && IsEqual(search_server.FindTopDocuments(query, DocumentStatus::BANNED), mapped.FindTopDocuments(query, DocumentStatus::BANNED))
+            && IsEqual(search_server.FindTopDocuments(execution::seq, query, is_even_rated, 20),
+                mapped.FindTopDocuments(query, is_even_rated, 20));
+        if (!is_equal) {
+            ++mismatches;
+            continue;
+        }
+        const int document_id = static_cast<int>(i * 10 % 3000 + 1);
+        if (document_id % 7 == 0) {
+            continue;
+        }
+        const auto [words, status] = search_server.MatchDocument(query, document_id);
+        const auto [mapped_words, mapped_status] = mapped.MatchDocument(query, document_id);
+        if (!equal(words.begin(), words.end(), mapped_words.begin(), mapped_words.end()) || status != mapped_status) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+bool TestRoundTrip(const string& path, const vector<string>& queries) {
+    const SearchServer search_server = MakeServer(1);
+    SaveIndexSnapshot(search_server, path);
+    const MappedSearchServer mapped(path);
+    const int mismatches = CountMismatches(search_server, mapped, queries);
+    if (mismatches > 0) {
+        cerr << "snapshot differs from the saved server on " << mismatches << " queries" << endl;
+        return false;
+    }
+    bool is_rejected = false;
+    try {
+        mapped.MatchDocument(queries.front(), 7);
+    }
+    catch (const out_of_range&) {
+        is_rejected = true;
+    }
+    if (!is_rejected) {
+        cerr << "snapshot matched a removed document" << endl;
+        return false;
+    }
+    return true;
+}
+
+string ReadFile(const string& path) {
+    ifstream input(path, ios::binary);
+    return string(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+}
+
+void WriteFile(const string& path, const string& image) {
+    ofstream(path, ios::binary | ios::trunc) << image;
+}
+
+// Returns false unless opening the image throws
+bool IsRejected(const string& path, const string& image) {
+    WriteFile(path, image);
+    try {
+        MappedSearchServer mapped(path);
+    }
+    catch (const invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+bool TestCorruptedSnapshots(const string& path, const string& corrupted_path) {
+    SaveIndexSnapshot(MakeServer(2), path);
+    const string image = ReadFile(path);
+    for (size_t size = 0; size < image.size(); size += image.size() / 97 + 1) {
+        if (!IsRejected(corrupted_path, image.substr(0, size))) {
+            cerr << "snapshot truncated to " << size << " bytes was opened" << endl;
+            return false;
+        }
+    }
+
+    IndexSnapshotHeader header;
+    memcpy(&header, image.data(), sizeof(header));
+    const auto with_header = [&image](const IndexSnapshotHeader& changed_header) {
+        string changed = image;
+        memcpy(changed.data(), &changed_header, sizeof(changed_header));
+        return changed;
+    };
+    IndexSnapshotHeader changed = header;
+    changed.magic[0] = 'X';
+    bool is_passed = IsRejected(corrupted_path, with_header(changed));
+    changed = header;
+    ++changed.version;
+    is_passed = is_passed && IsRejected(corrupted_path, with_header(changed));
+    changed = header;
+    changed.documents.count = image.size();
+    is_passed = is_passed && IsRejected(corrupted_path, with_header(changed));
+    changed = header;
+    changed.strings.offset = image.size() - 1;
+    is_passed = is_passed && IsRejected(corrupted_path, with_header(changed));
+
+    // A block pointing past the block bytes and a term pointing past the blocks
+    string broken_blocks = image;
+    IndexSnapshotBlock block;
+    memcpy(&block, image.data() + header.blocks.offset, sizeof(block));
+    block.bytes_offset = header.block_bytes.count;
+    memcpy(broken_blocks.data() + header.blocks.offset, &block, sizeof(block));
+    is_passed = is_passed && IsRejected(corrupted_path, broken_blocks);
+    string broken_terms = image;
+    IndexSnapshotTerm term;
+    memcpy(&term, image.data() + header.terms.offset, sizeof(term));
+    term.block_count = header.blocks.count + 1;
+    memcpy(broken_terms.data() + header.terms.offset, &term, sizeof(term));
+    is_passed = is_passed && IsRejected(corrupted_path, broken_terms);
+    if (!is_passed) {
+        cerr << "snapshot with a corrupted header or record was opened" << endl;
+    }
+    return is_passed;
+}
+
+// Saving replaces the file, so a server mapping the old one keeps answering from it
+bool TestResaveWhileMapped(const string& path, const vector<string>& queries) {
+    const SearchServer old_server = MakeServer(3);
+    const SearchServer new_server = MakeServer(4);
+    SaveIndexSnapshot(old_server, path);
+    const MappedSearchServer mapped(path);
+
+    atomic<bool> is_saved = false;
+    atomic<int> mismatches = 0;
+    thread reader([&]() {
+        do {
+            mismatches += CountMismatches(old_server, mapped, queries);
+        } while (!is_saved);
+    });
+    for (int i = 0; i < 5; ++i) {
+        SaveIndexSnapshot(i % 2 == 0 ? new_server : old_server, path);
+    }
+    SaveIndexSnapshot(new_server, path);
+    is_saved = true;
+    reader.join();
+    if (mismatches > 0) {
+        cerr << "mapped snapshot changed while the file was saved again" << endl;
+        return false;
+    }
+    if (CountMismatches(new_server, MappedSearchServer(path), queries) > 0) {
+        cerr << "snapshot saved over a mapped one differs from its server" << endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    const filesystem::path directory = filesystem::temp_directory_path() / ("index_snapshot_test_"s + to_string(getpid()));
+    filesystem::create_directories(directory);
+    const string path = (directory / "index.bin"s).string();
+    const vector<string> queries = MakeQueries();
+    const bool is_passed = TestRoundTrip(path, queries)
+        && TestCorruptedSnapshots(path, (directory / "corrupted.bin"s).string())
+        && TestResaveWhileMapped(path, queries);
+    // Only the snapshots themselves may be left, no temporary files
+    const size_t file_count = distance(filesystem::directory_iterator(directory), filesystem::directory_iterator());
+    filesystem::remove_all(directory);
+    if (is_passed && file_count != 2) {
+        cerr << file_count << " files left next to the snapshot" << endl;
+        return 1;
+    }
+    return is_passed ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <execution>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../benchmarks/corpus_generator.h"
+#include "../paginator.h"
+#include "../search_server.h"
+
+using namespace std;
+
+namespace {
+
+// Values of the page-th page of 0, 1, ..., size - 1
+vector<int> MakePage(int size, size_t page_size, size_t page) {
+    vector<int> values;
+    for (size_t value = page * page_size; value < min((page + 1) * page_size, static_cast<size_t>(size)); ++value) {
+        values.push_back(static_cast<int>(value));
+    }
+    return values;
+}
+
+template <typename Range>
+vector<int> ToVector(const Range& range) {
+    return vector<int>(range.begin(), range.end());
+}
+
+// Exact and partial last pages, for random access and forward iterators
+bool TestPageBounds() {
+    for (int size = 0; size < 30; ++size) {
+        vector<int> values(size);
+        iota(values.begin(), values.end(), 0);
+        const list<int> list_values(values.begin(), values.end());
+        for (size_t page_size = 1; page_size < 8; ++page_size) {
+            const size_t page_count = (size + page_size - 1) / page_size;
+            const auto pages = Paginate(values, page_size);
+            const auto list_pages = Paginate(list_values, page_size);
+            if (pages.size() != page_count || list_pages.size() != page_count || pages.empty() != (size == 0)) {
+                cerr << size << " values in pages of " << page_size << " make " << pages.size() << " pages" << endl;
+                return false;
+            }
+            for (size_t page = 0; page < page_count + 2; ++page) {
+                const auto range = pages.GetPage(page);
+                if (ToVector(range) != MakePage(size, page_size, page) || range.size() != MakePage(size, page_size, page).size()) {
+                    cerr << "page " << page << " of " << size << " values in pages of " << page_size << " is wrong" << endl;
+                    return false;
+                }
+            }
+            size_t page = 0;
+            for (const auto& range : list_pages) {
+                if (ToVector(range) != MakePage(size, page_size, page) || range.size() != MakePage(size, page_size, page).size()) {
+                    cerr << "list page " << page << " of " << size << " values in pages of " << page_size << " is wrong" << endl;
+                    return false;
+                }
+                ++page;
+            }
+            if (page != page_count) {
+                cerr << "iterating " << size << " list values in pages of " << page_size << " gave " << page << " pages" << endl;
+                return false;
+            }
+        }
+    }
+    bool is_rejected = false;
+    try {
+        Paginate(vector<int>{ 1 }, 0);
+    }
+    catch (const invalid_argument&) {
+        is_rejected = true;
+    }
+    if (!is_rejected) {
+        cerr << "pages of size 0 were accepted" << endl;
+    }
+    return is_rejected;
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Pages of the best results match slices of one search for all of them, and the
+// producer is called again only while it can still return more
+bool TestTopPages(const SearchServer& search_server, const vector<string>& queries) {
+    for (const string& query : queries) {
+        const vector<Document> documents = search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL,
+            numeric_limits<size_t>::max());
+        for (const size_t page_size : { 1, 3, 10 }) {
+            int call_count = 0;
+            auto pages = PaginateTop([&](size_t top_count) {
+                ++call_count;
+                return vector<Document>(documents.begin(), documents.begin() + min(top_count, documents.size()));
+            }, page_size);
+            size_t page = 0;
+            for (;; ++page) {
+                const vector<Document> page_documents = pages.GetPage(page);
+                const size_t first = min(page * page_size, documents.size());
+                const vector<Document> expected(documents.begin() + first,
+                    documents.begin() + min(first + page_size, documents.size()));
+                if (!IsEqual(page_documents, expected)) {
+                    cerr << "page " << page << " of \"" << query << "\" differs from a slice of all results" << endl;
+                    return false;
+                }
+                if (page_documents.empty()) {
+                    break;
+                }
+            }
+            // Each refetch at least doubles the results, the last one returns fewer than asked
+            size_t expected_call_count = 1;
+            for (size_t fetched = page_size; fetched <= documents.size(); fetched *= 2) {
+                ++expected_call_count;
+            }
+            const int completed_call_count = call_count;
+            pages.GetPage(0);
+            pages.GetPage(page + 10);
+            pages.GetPage(numeric_limits<size_t>::max());
+            if (call_count != static_cast<int>(expected_call_count) || call_count != completed_call_count) {
+                cerr << "paging through " << documents.size() << " results of \"" << query << "\" called the producer "
+                    << call_count << " times" << endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// With the server itself as the producer, near ties may be ordered differently,
+// but the pages together hold every result exactly once
+bool TestServerPages(const SearchServer& search_server, const vector<string>& queries) {
+    for (const string& query : queries) {
+        vector<Document> documents = search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL,
+            numeric_limits<size_t>::max());
+        auto pages = PaginateTop([&](size_t top_count) {
+            return search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, top_count);
+        }, 4);
+        vector<Document> paged_documents;
+        for (size_t page = 0;; ++page) {
+            const vector<Document> page_documents = pages.GetPage(page);
+            if (page_documents.empty()) {
+                break;
+            }
+            paged_documents.insert(paged_documents.end(), page_documents.begin(), page_documents.end());
+        }
+        const auto by_id = [](const Document& lhs, const Document& rhs) {
+            return lhs.id < rhs.id;
+        };
+        sort(documents.begin(), documents.end(), by_id);
+        sort(paged_documents.begin(), paged_documents.end(), by_id);
+        if (!IsEqual(paged_documents, documents)) {
+            cerr << "pages of \"" << query << "\" do not hold its " << documents.size() << " results" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    CorpusOptions corpus_options;
+    corpus_options.document_count = 3000;
+    corpus_options.vocabulary_size = 2000;
+    corpus_options.duplicate_ratio = 0.1;
+    SearchServer search_server("and in on the"s);
+    for (const GeneratedDocument& document : GenerateCorpus(corpus_options)) {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    QueryOptions query_options;
+    query_options.query_count = 100;
+    const vector<string> queries = GenerateQueries(corpus_options, query_options);
+    return TestPageBounds() && TestTopPages(search_server, queries) && TestServerPages(search_server, queries) ? 0 : 1;
+}
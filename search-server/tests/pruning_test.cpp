@@ -0,0 +1,117 @@
+#include <cmath>
+#include <execution>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../search_server.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "a b c"s;
+const size_t TOP_COUNTS[] = { 1, 5, 10, 50 };
+
+// Words of one or more letters, the first three of them are stop words
+string MakeWord(int rank) {
+    string word;
+    do {
+        word += static_cast<char>('a' + rank % 26);
+        rank /= 26;
+    } while (rank > 0);
+    return word;
+}
+
+// Skewed towards the first words, so that postings lists differ in length a lot
+int DrawRank(mt19937& generator, int vocabulary_size) {
+    return static_cast<int>(pow(uniform_real_distribution<double>(0.0, 1.0)(generator), 3.0) * vocabulary_size);
+}
+
+SearchServer MakeServer(mt19937& generator, int vocabulary_size) {
+    SearchServer search_server(STOP_WORDS);
+    vector<string> texts;
+    for (int document_id = 0; document_id < 8000; ++document_id) {
+        string text;
+        // Repeated texts give exact relevance ties, which only rating and id order
+        if (document_id > 10 && generator() % 4 == 0) {
+            text = texts[generator() % texts.size()];
+        }
+        else {
+            for (int i = 1 + generator() % 12; i > 0; --i) {
+                text += MakeWord(DrawRank(generator, vocabulary_size)) + ' ';
+            }
+        }
+        texts.push_back(text);
+        search_server.AddDocument(document_id, text, static_cast<DocumentStatus>(generator() % 4),
+            { static_cast<int>(generator() % 7) - 2 });
+    }
+    for (int document_id = 0; document_id < 8000; document_id += 7) {
+        search_server.RemoveDocument(document_id);
+    }
+    return search_server;
+}
+
+string MakeQuery(mt19937& generator, int vocabulary_size) {
+    string query;
+    for (int i = 1 + generator() % 6; i > 0; --i) {
+        if (generator() % 6 == 0) {
+            query += '-';
+        }
+        query += MakeWord(DrawRank(generator, vocabulary_size)) + ' ';
+    }
+    return query;
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Pruned retrieval has to return exactly what scoring every posting returns
+int CountMismatches(const SearchServer& pruned, const SearchServer& exhaustive, const string& query, size_t top_count) {
+    const auto is_odd_or_rated = [](int document_id, DocumentStatus, int rating) {
+        return document_id % 2 == 1 || rating > 1;
+    };
+    int mismatches = 0;
+    const auto check = [&mismatches](const vector<Document>& lhs, const vector<Document>& rhs) {
+        mismatches += IsEqual(lhs, rhs) ? 0 : 1;
+    };
+    check(pruned.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, top_count),
+        exhaustive.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, top_count));
+    check(pruned.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED, top_count),
+        exhaustive.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED, top_count));
+    check(pruned.FindTopDocuments(execution::seq, query, DocumentRatingPredicate{ 0, 2 }, top_count),
+        exhaustive.FindTopDocuments(execution::seq, query, DocumentRatingPredicate{ 0, 2 }, top_count));
+    check(pruned.FindTopDocuments(execution::seq, query, is_odd_or_rated, top_count),
+        exhaustive.FindTopDocuments(execution::seq, query, is_odd_or_rated, top_count));
+    return mismatches;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(11);
+    int mismatches = 0;
+    int checks = 0;
+    // A small vocabulary makes every list long, a large one leaves most of them short
+    for (const int vocabulary_size : { 30, 400, 5000 }) {
+        const SearchServer pruned = MakeServer(generator, vocabulary_size);
+        SearchServer exhaustive = pruned;
+        exhaustive.SetRetrievalMode(RetrievalMode::EXHAUSTIVE);
+        for (int i = 0; i < 300; ++i) {
+            const string query = MakeQuery(generator, vocabulary_size);
+            for (const size_t top_count : TOP_COUNTS) {
+                mismatches += CountMismatches(pruned, exhaustive, query, top_count);
+                checks += 4;
+            }
+        }
+    }
+    if (mismatches > 0) {
+        cerr << "pruned retrieval differs from the exhaustive one in " << mismatches << " of " << checks << " searches" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../benchmarks/corpus_generator.h"
+#include "../query_cache.h"
+
+using namespace std;
+
+namespace {
+
+const string STOP_WORDS = "and in on the"s;
+const int VOCABULARY_SIZE = 500;
+
+SearchServer MakeServer() {
+    CorpusOptions options;
+    options.document_count = 3000;
+    options.vocabulary_size = VOCABULARY_SIZE;
+    options.max_document_length = 20;
+    SearchServer search_server(STOP_WORDS);
+    for (const GeneratedDocument& document : GenerateCorpus(options)) {
+        search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+    }
+    return search_server;
+}
+
+vector<string> MakeQueries(int query_count) {
+    CorpusOptions corpus_options;
+    corpus_options.vocabulary_size = VOCABULARY_SIZE;
+    QueryOptions options;
+    options.query_count = query_count;
+    options.minus_word_ratio = 0.2;
+    return GenerateQueries(corpus_options, options);
+}
+
+bool IsEqual(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& a, const Document& b) {
+        return a.id == b.id && a.relevance == b.relevance && a.rating == b.rating;
+    });
+}
+
+// Counts the queries the cache answers differently from the server
+int CountMismatches(QueryCache& cache, const SearchServer& search_server, const vector<string>& queries) {
+    int mismatches = 0;
+    for (const string& query : queries) {
+        if (!IsEqual(cache.FindTopDocuments(query), search_server.FindTopDocuments(query))
+            || !IsEqual(cache.FindTopDocuments(query, DocumentStatus::BANNED), search_server.FindTopDocuments(query, DocumentStatus::BANNED))) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+// Every query stays cached, so only the generation check keeps results fresh
+bool TestChangesOfServer(const vector<string>& queries) {
+    SearchServer search_server = MakeServer();
+    QueryCache cache(search_server, 1 << 14);
+    CountMismatches(cache, search_server, queries);
+    const QueryCacheStats stats = cache.GetStats();
+    if (CountMismatches(cache, search_server, queries) > 0 || cache.GetStats().hits != stats.hits + 2 * queries.size()) {
+        cerr << "cache missed or changed results of an unchanged server" << endl;
+        return false;
+    }
+
+    // The new document repeats the words of a cached query and outranks every other document
+    const string& query = *find_if(queries.begin(), queries.end(), [](const string& query) {
+        return query.find('-') == string::npos;
+    });
+    const vector<Document> old_documents = cache.FindTopDocuments(query);
+    search_server.AddDocument(100000, query + ' ' + query, DocumentStatus::ACTUAL, { 100 });
+    if (IsEqual(cache.FindTopDocuments(query), old_documents) || CountMismatches(cache, search_server, queries) > 0) {
+        cerr << "cache returned results found before AddDocument" << endl;
+        return false;
+    }
+    search_server.RemoveDocument(100000);
+    for (int document_id = 0; document_id < 3000; document_id += 3) {
+        search_server.RemoveDocument(document_id);
+    }
+    if (CountMismatches(cache, search_server, queries) > 0) {
+        cerr << "cache returned results found before RemoveDocument" << endl;
+        return false;
+    }
+
+    // Reordered and repeated words make the same key
+    const QueryCacheStats before = cache.GetStats();
+    cache.FindTopDocuments("aa bb -cc"s);
+    cache.FindTopDocuments("bb aa aa -cc"s);
+    if (cache.GetStats().hits != before.hits + 1) {
+        cerr << "reordered query was not found in the cache" << endl;
+        return false;
+    }
+    return true;
+}
+
+// Far more queries than entries keep every set full, so lookups constantly evict
+bool TestEviction(const vector<string>& queries) {
+    const SearchServer search_server = MakeServer();
+    QueryCache cache(search_server, 32, 2);
+    mt19937 generator(7);
+    // Popular queries come back often enough to stay cached, the rest replace each other
+    const ZipfGenerator zipf(static_cast<int>(queries.size()), 1.0);
+    int mismatches = 0;
+    for (int i = 0; i < 20000; ++i) {
+        const string& query = queries[zipf(generator)];
+        const DocumentStatus status = generator() % 2 == 0 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED;
+        if (!IsEqual(cache.FindTopDocuments(query, status), search_server.FindTopDocuments(query, status))) {
+            ++mismatches;
+        }
+    }
+    const QueryCacheStats stats = cache.GetStats();
+    if (mismatches > 0) {
+        cerr << "cache under eviction returned wrong results for " << mismatches << " queries" << endl;
+        return false;
+    }
+    if (stats.hits == 0 || stats.misses < 1000) {
+        cerr << "cache of 32 entries had " << stats.hits << " hits and " << stats.misses << " misses" << endl;
+        return false;
+    }
+
+    // Concurrent lookups insert and evict in the same sets
+    atomic<int> thread_mismatches = 0;
+    vector<thread> threads;
+    for (uint32_t seed = 0; seed < 3; ++seed) {
+        threads.emplace_back([&, seed]() {
+            mt19937 thread_generator(seed);
+            for (int i = 0; i < 2000; ++i) {
+                const string& query = queries[zipf(thread_generator)];
+                if (!IsEqual(cache.FindTopDocuments(query), search_server.FindTopDocuments(query))) {
+                    ++thread_mismatches;
+                }
+            }
+        });
+    }
+    for (thread& lookup_thread : threads) {
+        lookup_thread.join();
+    }
+    if (thread_mismatches > 0) {
+        cerr << "concurrent lookups returned wrong results for " << thread_mismatches << " queries" << endl;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    return TestChangesOfServer(MakeQueries(200)) && TestEviction(MakeQueries(2000)) ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../request_queue.h"
+
+using namespace std;
+
+namespace {
+
+const int WINDOW_SIZE = 1440;
+const int THREAD_COUNT = 4;
+
+// Returns false and reports the check when the counts differ
+bool ExpectCount(const string& check, int count, int expected) {
+    if (count != expected) {
+        cerr << check << ": " << count << " requests without results, expected " << expected << endl;
+        return false;
+    }
+    return true;
+}
+
+bool TestSequential(const SearchServer& search_server) {
+    RequestQueue request_queue(search_server);
+    deque<bool> window;
+    int expected = 0;
+    mt19937 generator(1);
+    for (int i = 0; i < 10000; ++i) {
+        const bool is_empty = request_queue.AddFindRequest(generator() % 3 == 0 ? "bird"s : "cat"s).empty();
+        window.push_back(is_empty);
+        expected += is_empty;
+        if (static_cast<int>(window.size()) > WINDOW_SIZE) {
+            expected -= window.front();
+            window.pop_front();
+        }
+        if (!ExpectCount("sequential requests"s, request_queue.GetNoResultRequests(), expected)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whatever order concurrent requests got their times in, no bucket may keep a stale count
+// once a full window of later requests passed
+bool TestConcurrent(const SearchServer& search_server) {
+    RequestQueue request_queue(search_server);
+    vector<thread> threads;
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&request_queue, i]() {
+            mt19937 generator(i);
+            for (int j = 0; j < 5000; ++j) {
+                request_queue.AddFindRequest(generator() % 2 == 0 ? "bird"s : "cat"s);
+                request_queue.GetNoResultRequests();
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < WINDOW_SIZE; ++i) {
+        request_queue.AddFindRequest(i % 4 == 0 ? "bird"s : "cat"s);
+    }
+    if (!ExpectCount("window after concurrent requests"s, request_queue.GetNoResultRequests(), WINDOW_SIZE / 4)) {
+        return false;
+    }
+
+    threads.clear();
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&request_queue]() {
+            for (int j = 0; j < 3000; ++j) {
+                request_queue.AddFindRequest("bird"s);
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    return ExpectCount("concurrent requests without results"s, request_queue.GetNoResultRequests(), WINDOW_SIZE);
+}
+
+bool TestWallClock(const SearchServer& search_server) {
+    const auto bucket_width = chrono::milliseconds(1);
+    const auto window_width = bucket_width * (WINDOW_SIZE + 100);
+    RequestQueue request_queue(search_server, bucket_width);
+    for (int i = 0; i < 100; ++i) {
+        request_queue.AddFindRequest("bird"s);
+    }
+    request_queue.AddFindRequest("cat"s);
+    if (!ExpectCount("wall clock window"s, request_queue.GetNoResultRequests(), 100)) {
+        return false;
+    }
+    this_thread::sleep_for(window_width);
+    if (!ExpectCount("expired wall clock window"s, request_queue.GetNoResultRequests(), 0)) {
+        return false;
+    }
+
+    vector<thread> threads;
+    for (int i = 0; i < THREAD_COUNT; ++i) {
+        threads.emplace_back([&request_queue]() {
+            for (int j = 0; j < 2000; ++j) {
+                request_queue.AddFindRequest("bird"s);
+            }
+        });
+    }
+    for (thread& thread : threads) {
+        thread.join();
+    }
+    this_thread::sleep_for(window_width);
+    return ExpectCount("expired concurrent wall clock window"s, request_queue.GetNoResultRequests(), 0);
+}
+
+}  // namespace
+
+int main() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    const bool is_passed = TestSequential(search_server) && TestConcurrent(search_server) && TestWallClock(search_server);
+    return is_passed ? 0 : 1;
+}
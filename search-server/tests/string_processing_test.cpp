@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../string_processing.h"
+
+using namespace std;
+
+namespace {
+
+using CheckedWords = vector<pair<string_view, bool>>;
+
+// The word by word tokenizer ForEachCheckedWord replaced
+CheckedWords SplitIntoCheckedWordsNaive(string_view text) {
+    CheckedWords words;
+    while (true) {
+        const size_t word_begin = text.find_first_not_of(' ');
+        if (word_begin == text.npos) {
+            break;
+        }
+        text.remove_prefix(word_begin);
+        const string_view word = text.substr(0, min(text.find(' '), text.size()));
+        words.push_back({ word, any_of(word.begin(), word.end(), [](char c) {
+            return c >= '\0' && c < ' ';
+        }) });
+        text.remove_prefix(word.size());
+    }
+    return words;
+}
+
+// Texts with sparse and dense spaces, control characters and bytes above 0x7F.
+// Every tenth text spans several tokenizer chunks
+string GenerateText(mt19937& generator, int index) {
+    string text(generator() % (index % 10 == 0 ? 5000 : 200), 'a');
+    const int mode = generator() % 4;
+    for (char& c : text) {
+        const int roll = generator() % 100;
+        if (mode == 0) {
+            c = roll < 20 ? ' '
+                : roll < 22 ? static_cast<char>(generator() % 32)
+                : roll < 25 ? static_cast<char>(128 + generator() % 128)
+                : static_cast<char>('a' + generator() % 26);
+        }
+        else if (mode == 1) {
+            c = roll < 2 ? ' ' : static_cast<char>('a' + generator() % 26);
+        }
+        else if (mode == 2) {
+            c = roll < 70 ? ' ' : static_cast<char>('a' + roll % 5);
+        }
+        else {
+            c = static_cast<char>(generator() % 256);
+        }
+    }
+    return text;
+}
+
+}  // namespace
+
+int main() {
+    mt19937 generator(9);
+    int mismatches = 0;
+    for (int i = 0; i < 20000; ++i) {
+        const string text = GenerateText(generator, i);
+        CheckedWords words;
+        ForEachCheckedWord(text, [&words](string_view word, bool has_control_characters) {
+            words.push_back({ word, has_control_characters });
+        });
+        const CheckedWords expected = SplitIntoCheckedWordsNaive(text);
+        // Views are compared by position, the words have to point into the text
+        const bool is_equal = equal(words.begin(), words.end(), expected.begin(), expected.end(),
+            [](const pair<string_view, bool>& lhs, const pair<string_view, bool>& rhs) {
+                return lhs.first.data() == rhs.first.data() && lhs.first.size() == rhs.first.size() && lhs.second == rhs.second;
+            });
+        if (!is_equal) {
+            ++mismatches;
+        }
+    }
+    if (mismatches > 0) {
+        cerr << "ForEachCheckedWord differs from the naive tokenizer on " << mismatches << " texts" << endl;
+        return 1;
+    }
+
+    for (int i = 0; i < 64; ++i) {
+        if (CountTrailingZeros(uint64_t{ 1 } << i | uint64_t{ 1 } << 63) != i) {
+            cerr << "CountTrailingZeros is wrong for bit " << i << endl;
+            return 1;
+        }
+    }
+    return 0;
+}